@@ -0,0 +1,63 @@
+// Copyright 2020 Barger M., Knoll M., Kofler L.
+#ifndef INCLUDE_ALAW_HPP_
+#define INCLUDE_ALAW_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+// Decodes a single PCMA (A-law) encoded sample
+//
+// number: encoded sample
+//
+// return: 16 bit PCM sample
+constexpr int16_t DecodeAlawValue(uint8_t number) {
+  number ^= 0x55;
+  bool negative = (number & 0x80) != 0;
+  int exponent = (number & 0x70) >> 4;
+  int mantissa = number & 0x0F;
+  int decoded = 0;
+
+  if (exponent != 0) {
+    decoded = (1 << (exponent + 4)) | (mantissa << exponent) | (1 << (exponent - 1));
+  } else {
+    decoded = (mantissa << 1) | 1;
+  }
+
+  return static_cast<int16_t>(negative ? -decoded : decoded);
+}
+
+// Lookup table of all 256 decoded samples
+struct AlawTable {
+  int16_t values[256];
+};
+
+constexpr AlawTable MakeAlawTable() {
+  AlawTable table = {};
+  for (int i = 0; i < 256; i++) {
+    table.values[i] = DecodeAlawValue(static_cast<uint8_t>(i));
+  }
+  return table;
+}
+
+// Generated at compile time
+inline constexpr AlawTable alaw_table = MakeAlawTable();
+
+// Decodes PCMA (A-law) encoded samples with the fastest kernel supported by
+// the cpu (AVX2, SSSE3 or the lookup table).
+//
+// alaw_samples: encoded samples
+// len: number of samples
+// samples: output buffer, has to be able to hold len samples
+void DecodeAlaw(const int8_t *alaw_samples, size_t len, int16_t *samples);
+
+// See DecodeAlaw(), always uses the lookup table
+void DecodeAlawScalar(const int8_t *alaw_samples, size_t len, int16_t *samples);
+
+#if defined(__x86_64__) || defined(__i386__)
+// See DecodeAlaw(), these kernels may only be called if the cpu supports the
+// instruction set
+void DecodeAlawSSSE3(const int8_t *alaw_samples, size_t len, int16_t *samples);
+void DecodeAlawAVX2(const int8_t *alaw_samples, size_t len, int16_t *samples);
+#endif
+
+#endif  // INCLUDE_ALAW_HPP_
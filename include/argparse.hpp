@@ -6,8 +6,12 @@
 #include <string>
 #include <vector>
 #include <fstream>
+#include <thread> // NOLINT
 #include <boost/program_options.hpp>
 #include "log.hpp"
+#include "audio_analyzer.hpp"
+#include "number_list.hpp"
+#include "db_client.hpp"
 
 namespace po = boost::program_options;
 
@@ -23,18 +27,32 @@ class Argparser {
     std::string GetPassword();
     // Returns the server uri at the argument -s
     std::string GetServer();
-    // Returns a vector with all numbers specified with the argument -n
-    std::vector<std::string> GetNumbers();
+    // Returns all numbers specified with the arguments -n and -f
+    const NumberList& GetNumbers();
     // Returns the the value of the argument -t
     int GetThreads();
     // Returns the path to the audiofile at the argument -f
     std::string GetPathToAudio();
+    // Returns the path to the JSONL file at the argument -o, empty if not specified
+    std::string GetPathToOutput();
+    // Returns the number of analysis threads, the value of -t if specified
+    // or the number of cores otherwise
+    int GetAnalysisThreads();
     // Returns true if all arguments are specified to successfully analyse a file
     bool DoAnalyse();
     // Returns true if all arguments are specified to successfully wardial
     bool DoWardial();
     // Returns true if rtp data is to be saved to the disk
     bool GetDebugStatus();
+    // Returns true if calls are to be analyzed while running and terminated early
+    bool GetEarlyHangup();
+    // Returns the detector engine specified with the argument --engine
+    DetectorEngine GetEngine();
+    // Returns true if RTP streams are to be received by the epoll engine
+    // instead of oRTP, specified with the argument --rtp
+    bool GetRtpEngine();
+    // Returns the database settings selected with the argument --durability
+    DBProfile GetDBProfile();
 
  private:
     Argparser();
@@ -45,13 +63,14 @@ class Argparser {
     // Prints usage informations
     void PrintUsage(bool help);
     // Variables
-    // Vector where all numbers are stored
-    std::vector<std::string> numbers;
+    // List where all numbers are stored
+    NumberList numbers;
     static Argparser* instance;
     bool analyze_flag = false;
     bool dial_flag = false;
     bool wardial_flag = false;
     bool debug = false;
+    bool early_hangup = false;
     int threads;
     std::string username;
     std::string password;
@@ -59,6 +78,10 @@ class Argparser {
     std::string number;
     std::string path_to_audio;
     std::string path_to_numbers;
+    std::string path_to_output;
+    std::string engine;
+    std::string rtp;
+    std::string durability;
     po::variables_map vm;
     po::variables_map dial_vm;
     po::variables_map analyze_vm;
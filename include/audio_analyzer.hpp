@@ -6,36 +6,111 @@
 
 #include <string>
 #include <vector>
+#include <array>
 #include <cmath>
+#include <cstdint>
 #include <algorithm>
 #include <functional>
-#include <map>
 #include <set>
 
 #include "wav.hpp"
 #include "log.hpp"
+#include "fft_plan_cache.hpp"
+#include "spectrogram.hpp"
 
 #include "./kiss_fft.h"
 #include "tools/kiss_fftr.h"
 
 #define NFFT 8192
+#define SAMPLE_RATE 8000
+// Number of frequency bins below the nyquist frequency
+#define NFREQS (NFFT / 2 - 1)
+// Default number of peaks per frame which are counted by the classifiers
+#define PEAK_COUNT 10
+// Width of the buckets of the significant frequency histogram in Hz
+#define BUCKET_WIDTH 5
+// Number of buckets, including the bucket of the nyquist frequency
+#define FCNT_BUCKETS (SAMPLE_RATE / 2 / BUCKET_WIDTH + 1)
+
+// The goertzel engine splits each frame into blocks of NFFT / GOERTZEL_BLOCKS
+// samples, which gives every filter a bandwidth of about 5 Hz.
+#define GOERTZEL_BLOCKS 5
+#define GOERTZEL_TONES 12
+// Minimum share of the energy of a block a tone needs to be detected in it.
+//
+// The goertzel engine approximates the fft peak counts the classifiers were
+// tuned on: the 10 highest bins of a frame with a pure tone are the bins
+// around it, of which about BUCKET_WIDTH (one per block) fall into the bucket
+// of the tone. So every block stands in for PEAK_COUNT / GOERTZEL_BLOCKS of
+// the peaks, and each of the strongest detected tones of the block counts as
+// one peak in its bucket. Steady tones get the same counts from both engines,
+// a tone which only fills a part of a frame is counted for the blocks it is
+// detected in, while the fft counts the whole frame if the tone is its
+// strongest signal.
+#define GOERTZEL_THRESHOLD 0.02
 
 enum LineType {
   FAX, MODEM, OTHER
 };
 
+// Engine used to find the peaks in each frame
+//
+// FFT: full spectrum of the frame, the 10 highest bins are the peaks
+// GOERTZEL: goertzel filter bank which only evaluates the frequencies used by
+//           the classifiers. Much cheaper, but peaks at other frequencies
+//           are not seen.
+enum DetectorEngine {
+  FFT, GOERTZEL
+};
+
 // represents a point in the spectrum coordinate system
 struct Measurement {
   float frequency, power;
+  int bin;
+};
+
+// Returns the frequency of a fft bin
+constexpr float BinFrequency(int bin) {
+  return static_cast<float>(bin) * (static_cast<float>(SAMPLE_RATE) / 2) / static_cast<float>(NFREQS);
+}
+
+// Returns the index of the histogram bucket a frequency is rounded to
+constexpr int FrequencyBucket(double frequency) {
+  double buckets = frequency / BUCKET_WIDTH;
+  int idx = static_cast<int>(buckets);
+  return (buckets - idx >= 0.5) ? idx + 1 : idx;
+}
+
+// Frequency and histogram bucket of every fft bin
+struct SpectrumAxis {
+  float frequency[NFREQS];
+  uint16_t bucket[NFREQS];
 };
 
+constexpr SpectrumAxis MakeSpectrumAxis() {
+  SpectrumAxis axis = {};
+  for (int i = 0; i < NFREQS; i++) {
+    axis.frequency[i] = BinFrequency(i);
+    axis.bucket[i] = FrequencyBucket(axis.frequency[i]);
+  }
+  return axis;
+}
+
+// Generated at compile time for NFFT and SAMPLE_RATE
+inline constexpr SpectrumAxis spectrum_axis = MakeSpectrumAxis();
+
 class AudioAnalyzer {
  public:
   // Constructor
   //
-  // wav: Pointer to a Wav object, which contains information about
-  // the pcm file
-  AudioAnalyzer();
+  // engine: Engine used to find the peaks in the audio
+  explicit AudioAnalyzer(DetectorEngine engine = DetectorEngine::FFT);
+
+  // Destructor
+  ~AudioAnalyzer();
+
+  AudioAnalyzer(const AudioAnalyzer&) = delete;
+  AudioAnalyzer& operator=(const AudioAnalyzer&) = delete;
 
   // Returns the max frequency
   int GetMaxFrequency();
@@ -52,22 +127,85 @@ class AudioAnalyzer {
   // will be printed
   void PrintSignificantFrequencies(float bottom_limit);
 
-  void Analyze(Wav *wav);
+  // Analyzes a whole recording
+  //
+  // wav: the recording, the sample rate has to be SAMPLE_RATE
+  //
+  // Returns false if the recording has another sample rate and was not analyzed
+  bool Analyze(Wav *wav);
+
+  // Feeds a chunk of a running audio stream into the analyzer, e.g. the
+  // payload of a single RTP packet. Every time NFFT samples have been
+  // collected the frame is analyzed and the classifier state is updated.
+  //
+  // alaw_samples: PCMA (A-law) encoded samples with a sample rate of 8000
+  // len: number of samples
+  void Feed(const int8_t *alaw_samples, size_t len);
+
+  // See Feed(const int8_t *alaw_samples, size_t len)
+  // The difference is, that this method takes decoded PCM samples
+  void Feed(const int16_t *samples, size_t len);
+
+  // Analyzes the samples of an incomplete last frame of a stream. Has to be
+  // called after the last chunk has been fed, before the line type is read.
+  void Finish();
+
+  // Returns true as soon as the audio fed so far is classified as modem or fax
+  bool HasVerdict();
+
+  // Sets the number of highest peaks per frame which are added to the
+  // significant frequencies and checked for the peak frequency. The
+  // classifier thresholds are tuned for the default of PEAK_COUNT.
+  //
+  // peak_count: number of peaks per frame
+  void SetPeakCount(uint peak_count);
+
+  // Sets if the spectrum of every frame is kept after it has been analyzed.
+  // Not needed for the classification, which only uses the peaks.
+  //
+  // retain_spectra: true to keep the spectra (default), false to drop them
+  void SetRetainSpectra(bool retain_spectra);
+
+  // Returns the spectra of all analyzed frames, empty if they are not retained
+  const Spectrogram &GetSpectra();
 
  private:
   Wav *wav;                                         // audio data and further information about the audio file
-  std::vector<std::vector<Measurement>> spectra;    // frequency spectra of each second
-  std::map<int, float> fcnt;                        // significant frequencies in the audio
+  Spectrogram spectra;                              // frequency spectra of each frame
+  bool retain_spectra;                              // true if spectra are kept
+  std::array<float, FCNT_BUCKETS> fcnt;             // significant frequencies in the audio by bucket
   int max_frq;                                      // max frequency in the audio
   int max_peak;                                     // peak of the max frequency
+  bool verdict;                                     // true if a modem or fax has been detected
+  DetectorEngine engine;                            // engine used to find the peaks
+  uint peak_count;                                  // number of peaks per frame
+  std::vector<Measurement> peaks;                   // highest peaks of the current frame
+  float goertzel_coeffs[GOERTZEL_TONES];            // coefficients of the goertzel filters
+
+  kiss_fft_scalar *tbuf;                            // samples of the current frame
+  uint frame_len;                                   // number of samples buffered in tbuf
 
-  // Performs fft on every second in the file and extracts the
+  // Performs fft on every full frame in the file and extracts the
   // frequency spectrum from it.
   void GetSpectraFromFile(Wav *wav);
 
-  // Calculates significant frequencies from each spectrum.
-  // Result is saved in fcnt.
-  void CalculateSignificantFrequencies();
+  // Performs fft on the frame in tbuf, stores its spectrum and updates the
+  // significant frequencies and the peak frequency.
+  void AnalyzeFrame();
+
+  // Runs the goertzel filter bank on the frame in tbuf and updates the
+  // significant frequencies and the peak frequency.
+  void AnalyzeFrameGoertzel();
+
+  // Selects the highest peaks of a power spectrum into peaks
+  //
+  // power: power of each bin in dB
+  void SelectPeaks(const float *power);
+
+  // Adds the peaks of a frame to the significant frequencies in fcnt
+  //
+  // peaks: highest peaks of the frame, sorted by power
+  void CalculateSignificantFrequencies(const std::vector<Measurement> &peaks);
 
   // Checks, if the significant frequencies match to a modem
   bool IsModem();
@@ -75,8 +213,10 @@ class AudioAnalyzer {
   // Checks, if the significant frequencies match to a modem
   bool IsFax();
 
-  // Calculates the peak frequency in the audio file
-  void CalculatePeakFrequency();
+  // Updates the peak frequency with the peaks of a frame
+  //
+  // peaks: highest peaks of the frame, sorted by power
+  void CalculatePeakFrequency(const std::vector<Measurement> &peaks);
 };
 
 #endif  // INCLUDE_AUDIO_ANALYZER_HPP_
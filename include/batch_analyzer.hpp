@@ -0,0 +1,53 @@
+// Copyright 2020 Barger M., Knoll M., Kofler L.
+#ifndef INCLUDE_BATCH_ANALYZER_HPP_
+#define INCLUDE_BATCH_ANALYZER_HPP_
+
+#include <string>
+#include <vector>
+
+#include "audio_analyzer.hpp"
+
+// Result of the analysis of one recording
+struct BatchResult {
+  std::string file;         // Path to the analyzed file
+  std::string status;       // "Finished" or "Analyzing failed"
+  std::string dev_type;     // Readable line type, empty if the analysis failed
+  int line_type;            // LineType, -1 if the analysis failed
+  double duration;          // Duration of the recording in seconds
+  double analysis_ms;       // Time needed to read and analyze the file
+};
+
+// Expands the argument of -a into a list of recordings.
+//
+// path: A wav file, a directory which is searched recursively for *.wav
+//       files, a wildcard pattern or a file which lists one path per line
+//
+// return: paths of all recordings to analyze, sorted
+std::vector<std::string> CollectAudioFiles(const std::string &path);
+
+// Analyzes a single recording
+//
+// file: path to the wav file
+// engine: detector engine to use
+//
+// return: result of the analysis including the timing
+BatchResult AnalyzeAudioFile(const std::string &file, DetectorEngine engine);
+
+// Returns true if the argument of -a names a single recording and not a
+// directory, a wildcard pattern or a list of recordings
+//
+// path: argument of -a
+bool IsSingleRecording(const std::string &path);
+
+// Escapes a string to be used as a JSON string value
+std::string EscapeJson(const std::string &str);
+
+// Analyzes all recordings specified with -a on a pool of worker threads.
+// The results are written to the recordings table of the database, or to the
+// JSONL file given with -o. The result of a single recording without -o is
+// only logged.
+//
+// return: 0 on success, 1 if no recording was found
+int BatchAnalyzer();
+
+#endif  //  INCLUDE_BATCH_ANALYZER_HPP_
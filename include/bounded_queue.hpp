@@ -0,0 +1,132 @@
+// Copyright 2020 Barger M., Knoll M., Kofler L.
+#ifndef INCLUDE_BOUNDED_QUEUE_HPP_
+#define INCLUDE_BOUNDED_QUEUE_HPP_
+
+#include <condition_variable> // NOLINT
+#include <cstddef>
+#include <deque>
+#include <mutex> // NOLINT
+#include <utility>
+
+// Blocking multi producer, multi consumer queue with a fixed capacity.
+//
+// Producers block while the queue is full, so a slow consumer throttles the
+// producers instead of letting the queue grow without limit. Producers which
+// must not block wait for space with WaitForSpace() before they start the work
+// which produces an element and append it with PushNoWait().
+template <typename T>
+class BoundedQueue {
+ public:
+  // Constructor
+  //
+  // capacity: Maximum number of queued elements
+  explicit BoundedQueue(size_t capacity) : capacity(capacity > 0 ? capacity : 1) {}
+
+  BoundedQueue(const BoundedQueue&) = delete;
+  BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+  // Appends an element, blocks while the queue is full
+  //
+  // item: Element to append
+  //
+  // return: false if the queue has been closed and the element was dropped
+  bool Push(T item) {
+    std::unique_lock<std::mutex> lock(mutex);
+    not_full.wait(lock, [this] { return closed || items.size() < capacity; });
+    if (closed) {
+      return false;
+    }
+    items.push_back(std::move(item));
+    if (items.size() > max_size) {
+      max_size = items.size();
+    }
+    lock.unlock();
+    not_empty.notify_one();
+    return true;
+  }
+
+  // Appends an element without waiting, the queue may exceed its capacity
+  //
+  // item: Element to append
+  //
+  // return: false if the queue has been closed and the element was dropped
+  bool PushNoWait(T item) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (closed) {
+      return false;
+    }
+    items.push_back(std::move(item));
+    if (items.size() > max_size) {
+      max_size = items.size();
+    }
+    lock.unlock();
+    not_empty.notify_one();
+    return true;
+  }
+
+  // Blocks while the queue is full, without appending an element
+  //
+  // return: false if the queue has been closed
+  bool WaitForSpace() {
+    std::unique_lock<std::mutex> lock(mutex);
+    not_full.wait(lock, [this] { return closed || items.size() < capacity; });
+    return !closed;
+  }
+
+  // Removes the oldest element, blocks while the queue is empty
+  //
+  // item: Receives the removed element
+  //
+  // return: false if the queue has been closed and all elements are consumed
+  bool Pop(T *item) {
+    std::unique_lock<std::mutex> lock(mutex);
+    not_empty.wait(lock, [this] { return closed || !items.empty(); });
+    if (items.empty()) {
+      return false;
+    }
+    *item = std::move(items.front());
+    items.pop_front();
+    lock.unlock();
+    // WaitForSpace() does not take the space, so all waiters are woken up
+    not_full.notify_all();
+    return true;
+  }
+
+  // Closes the queue. Further pushes fail, queued elements can still be popped.
+  void Close() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      closed = true;
+    }
+    not_empty.notify_all();
+    not_full.notify_all();
+  }
+
+  // return: Number of queued elements
+  size_t Size() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return items.size();
+  }
+
+  // return: Highest number of queued elements so far
+  size_t GetMaxSize() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return max_size;
+  }
+
+  // return: Maximum number of queued elements
+  size_t GetCapacity() const {
+    return capacity;
+  }
+
+ private:
+  const size_t capacity;
+  size_t max_size = 0;
+  bool closed = false;
+  std::deque<T> items;
+  std::mutex mutex;
+  std::condition_variable not_empty;
+  std::condition_variable not_full;
+};
+
+#endif  //  INCLUDE_BOUNDED_QUEUE_HPP_
@@ -0,0 +1,146 @@
+// Copyright 2020 Barger M., Knoll M., Kofler L.
+#ifndef INCLUDE_CALL_MANAGER_HPP_
+#define INCLUDE_CALL_MANAGER_HPP_
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+#include <osip2/osip.h>
+#include <osipparser2/osip_parser.h>
+#include <eXosip2/eXosip.h>
+
+#include <atomic>
+#include <map>
+#include <mutex> // NOLINT
+#include <string>
+#include <thread> // NOLINT
+
+#include "log.hpp"
+#include "registration_manager.hpp"
+#include "timing_wheel.hpp"
+
+// Resolution of the call timers in milliseconds
+#define TIMER_TICK_MS 20
+
+// Receives the SIP events of one call
+class CallHandler {
+ public:
+  virtual ~CallHandler() {}
+
+  // Processes an event of the call. Called by the event thread of the call
+  // manager, so it must not block. No lock of the call manager is held.
+  //
+  // event: The event, it is freed after this method returns
+  virtual void OnEvent(eXosip_event_t *event) = 0;
+
+  // Processes an expired timer of the call. Called by the event thread.
+  //
+  // id: Id returned by CallManager::StartTimer()
+  virtual void OnTimeout(TimingWheel::TimerId id) = 0;
+};
+
+// Owns the one eXosip context of the process. All calls share its SIP socket
+// and the registration of the account. A single event thread receives all
+// events and passes them to the handler of the call they belong to. It also
+// runs the timers of all calls on one timing wheel.
+class CallManager {
+ public:
+  // Constructor
+  //
+  // username: SIP username
+  // password: SIP password
+  // uri: The SIP Trunk uri of your provider
+  // port: The local SIP port
+  CallManager(std::string username, std::string password, std::string uri, int port);
+
+  // Destructor, deregisters and stops the event thread. All calls have to
+  // be ended.
+  ~CallManager();
+
+  // Registers the account once, the registration is refreshed in the
+  // background afterwards. See RegistrationManager::Register()
+  //
+  // Returns true if successfull, else false
+  bool Register();
+
+  // Sends an INVITE. All events of the new call are passed to the handler
+  // until RemoveCall() is called.
+  //
+  // invite_msg: The INVITE message
+  // handler: Handler for the events of the call
+  //
+  // Returns the call id, or a value <= 0 if the INVITE could not be sent
+  int SendInvite(osip_message_t *invite_msg, CallHandler *handler);
+
+  // Stops routing the events of a call. Has to be called by the handler of
+  // the call on the event thread, afterwards the handler is not called
+  // anymore and may be deleted.
+  //
+  // cid: Call id returned by SendInvite()
+  void RemoveCall(int cid);
+
+  // Starts a timer for a call. When it expires, OnTimeout() of the handler
+  // of the call is run on the event thread.
+  //
+  // cid: Call id returned by SendInvite()
+  // delay_ms: Time until the timer expires in milliseconds
+  //
+  // Returns the id of the timer
+  TimingWheel::TimerId StartTimer(int cid, int delay_ms);
+
+  // Cancels a timer
+  //
+  // id: Id returned by StartTimer()
+  void CancelTimer(TimingWheel::TimerId id);
+
+  // Returns the eXosip context shared by all calls
+  eXosip_t *GetContext();
+
+  // Returns the URI of the SIP provider
+  std::string GetServerUri();
+
+  // Returns the SIP username
+  std::string GetUsername();
+
+  // Returns true if registered with the SIP provider
+  bool IsRegistered();
+
+  // Waits until a lost registration is back, see
+  // RegistrationManager::WaitForRegistration()
+  //
+  // cancel: Stops waiting when it is set
+  //
+  // Returns true if registered with the SIP provider
+  bool WaitForRegistration(const std::atomic<bool> &cancel);
+
+ private:
+  // Receives all events and dispatches them until the manager is destroyed
+  void EventLoop();
+
+  // Routes an event to the registration or to the handler of its call and
+  // frees it afterwards
+  void Dispatch(eXosip_event_t *event);
+
+  // Passes an expired timer to the handler of its call
+  void DispatchTimeout(int cid, TimingWheel::TimerId id);
+
+  // Returns the handler of a call, nullptr if the call has been removed
+  //
+  // cid: Call id returned by SendInvite()
+  CallHandler *FindCall(int cid);
+
+  eXosip_t *context;            // eXosip context
+
+  std::string server_uri;       // URI of the SIP provider
+  std::string username;         // SIP Username
+  RegistrationManager *registration;  // Registration of the account
+
+  std::mutex calls_mutex;                 // Guards calls
+  std::map<int, CallHandler *> calls;     // Handlers of all active calls by call id
+  TimingWheel timers;                     // Timers of all calls
+
+  std::atomic<bool> running;    // False when the event thread should stop
+  std::thread event_thread;     // Thread which runs EventLoop()
+};
+
+#endif  // INCLUDE_CALL_MANAGER_HPP_
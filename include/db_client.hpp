@@ -4,41 +4,243 @@
 #define INCLUDE_DB_CLIENT_HPP_
 
 #include <sqlite3.h>
+#include <cstdint>
 #include <string>
 #include "log.hpp"
 
+// Settings applied to the database connection when it is opened. The default
+// is the fast profile.
+struct DBProfile {
+  std::string journal_mode = "WAL";     // WAL lets readers work while a campaign writes
+  std::string synchronous = "NORMAL";   // With WAL only checkpoints are synced
+  int64_t mmap_size = 268435456;        // Bytes of the file which are memory mapped
+  int cache_size = -16384;              // Page cache, negative values are KiB
+  int busy_timeout = 5000;              // Time to wait for a lock in milliseconds
+
+  // Looks up a profile by name
+  //
+  // name: fast (WAL, synchronous=NORMAL, large cache and mmap),
+  //       safe (WAL, synchronous=FULL, every commit is synced) or
+  //       compat (rollback journal, synchronous=FULL, for file systems without
+  //       shared memory, e.g. network shares)
+  // profile: Receives the profile
+  //
+  // Returns false if the name is unknown
+  static bool FromName(const std::string &name, DBProfile *profile);
+};
+
+// Version of the schema stored in pragma user_version. Version 1 is the
+// original calls table with text ids, version 2 has no analysis time of the
+// recordings. Both are migrated when they are opened.
+#define DB_SCHEMA_VERSION 3
+
+// Status codes of the status columns, the names are in the table statuses.
+// Ready, Calling, Analyzing and Unknown are only found in entries migrated
+// from version 1.
+enum CallStatus {
+  STATUS_READY = 0,
+  STATUS_CALLING = 1,
+  STATUS_CALL_FINISHED = 2,
+  STATUS_CALL_FAILED = 3,
+  STATUS_ANALYZING = 4,
+  STATUS_FINISHED = 5,
+  STATUS_ANALYZING_FAILED = 6,
+  STATUS_UNKNOWN = 7,
+};
+
+// All fields of one entry of the calls table. A worker fills the record while
+// a call progresses and only writes it at the checkpoints which have to be
+// visible in the database, see DBClient::WriteRecord().
+struct CallRecord {
+  int64_t seq = 0;              // Number of this call in the campaign, unique per campaign
+  std::string number;           // Target number of this call
+  int64_t start_time = 0;       // Unix time the call was started
+  int duration = -1;            // Call duration in seconds, negative if unknown
+  CallStatus status = STATUS_READY;
+  int dev_type = -1;            // LineType of the device, negative if not analyzed
+
+  CallRecord() = default;
+
+  // Creates a record for a call which is started now
+  //
+  // seq: Number of this call in the campaign
+  // number: Target number of this call
+  CallRecord(int64_t seq, std::string number);
+};
+
+// Splits a number into its value and the count of its leading zeros, the
+// value without leading zeros fits into a signed 64 bit integer. A leading +
+// is dropped, E.164 numbers are stored without it.
+//
+// number: The number as dialed
+// value: Receives the number without leading zeros
+// leading_zeros: Receives the count of leading zeros
+//
+// Returns false if the number contains other characters than digits or has
+// more than 18 digits without or more than 18 leading zeros
+bool SplitNumber(const std::string &number, int64_t *value, int *leading_zeros);
+
+// Client for the database. Every statement is prepared once on first use and
+// reused for all following rows. Not thread-safe, see DBWriter.
+//
+// Schema version 3:
+//   campaigns(id, start_time): one entry per run which placed calls
+//   calls(id, campaign, seq, number, leading_zeros, start_time, duration,
+//         status, dev_type): one entry per call, the number is stored as
+//         integer without its leading zeros
+//   recordings(id, path, start_time, duration, status, dev_type, analysis_ms):
+//         results of the batch analysis and the time it took in milliseconds
+//   statuses(id, name), device_types(id, name): names of the codes
+// The views calls_readable and recordings_readable show the entries with
+// names and formatted numbers and times.
 class DBClient {
  public:
-  // Constructor
-  explicit DBClient(std::string path);
+  // Constructor, opens the database, applies the profile and creates or
+  // migrates the schema
+  //
+  // path: Path to the database
+  // profile: Settings of the connection
+  explicit DBClient(std::string path, const DBProfile &profile = DBProfile());
 
   // Destructor
   ~DBClient();
 
-  // Insert a new set of data into the database
+  DBClient(const DBClient&) = delete;
+  DBClient& operator=(const DBClient&) = delete;
+
+  // Returns true if the database is open and has the current schema, no
+  // changes can be written otherwise
+  bool IsOpen();
+
+  // Reads a setting of this connection, e.g. to check the applied profile
   //
-  // id: Id of this call
-  // number: Target number of this call
-  // status: Current status in the processing chain
-  // dev_type: Device type if fully analyzed
+  // name: Name of the pragma, e.g. synchronous
+  //
+  // Returns the value as text, empty if the pragma has no value
+  std::string GetPragma(const std::string &name);
+
+  // Inserts a record into the table calls or replaces status, device type
+  // and duration if the call has already been written, so a call takes one
+  // statement per checkpoint. The first record starts a new campaign.
+  //
+  // record: The record, number and start time are only written by the insert
+  //
+  // Returns true if successfull, else false
+  bool WriteRecord(const CallRecord &record);
+
+  // Inserts the result of a batch analysis into the table recordings or
+  // replaces status, device type and duration if the recording has already
+  // been analyzed
+  //
+  // path: Path to the recording
+  // status: STATUS_FINISHED or STATUS_ANALYZING_FAILED
+  // dev_type: LineType of the device, negative if the analysis failed
+  // duration: Duration of the recording in seconds
+  // analysis_ms: Time needed to read and analyze the recording in milliseconds
   //
-  bool InsertData(std::string id, std::string number, std::string status, std::string dev_type);
+  // Returns true if successfull, else false
+  bool WriteRecording(const std::string &path, CallStatus status, int dev_type, int duration, double analysis_ms);
 
-  // Updates the status and/or device type of an entry in the table calls
+  // Starts a transaction, all following changes are committed together. The
+  // write lock is taken at once, waiting up to the busy timeout of the profile.
   //
-  // id: Id of the entry to update
-  // status: new status, empty if it is not to be changed
-  // dev_type: new device type, empty if it is not to be changed
-  bool UpdateEntry(std::string id, std::string status, std::string dev_type);
+  // Returns true if successfull, else false
+  bool BeginTransaction();
 
-  // Updates the call duration to the given integer
+  // Commits the transaction started with BeginTransaction()
   //
-  // id: Id of the entry to update
-  // duration: The call duration in seconds
-  bool UpdateDuration(std::string id, int duration);
+  // Returns true if successfull, else false
+  bool CommitTransaction();
+
+  // Discards the changes of the transaction started with BeginTransaction(),
+  // a campaign started in it is started again by the next record
+  //
+  // Returns true if successfull, else false
+  bool RollbackTransaction();
 
  private:
+  // All statements which are prepared once
+  enum StatementType {
+    STMT_CAMPAIGN,
+    STMT_RECORD,
+    STMT_RECORDING,
+    STMT_COUNT,
+  };
+
+  // A prepared statement and the indexes of its parameters, 0 if the
+  // statement does not have the parameter
+  struct Statement {
+    sqlite3_stmt *stmt = nullptr;
+    int campaign = 0;
+    int seq = 0;
+    int number = 0;
+    int leading_zeros = 0;
+    int path = 0;
+    int start_time = 0;
+    int duration = 0;
+    int status = 0;
+    int dev_type = 0;
+    int analysis_ms = 0;
+  };
+
+  // Creates the tables of the current schema, migrates a version 1 table
+  //
+  // Returns true if successfull, else false
+  bool CreateSchema();
+
+  // Copies the entries of the version 1 table calls_v1 into the version 2
+  // tables, called inside the transaction of CreateSchema()
+  //
+  // Returns true if successfull, else false
+  bool MigrateV1();
+
+  // Starts the campaign of this client, called before its first call is
+  // written
+  //
+  // Returns true if successfull, else false
+  bool StartCampaign();
+
+  // Returns a prepared statement, it is prepared on the first call
+  //
+  // type: The statement
+  //
+  // Returns the statement, nullptr if it could not be prepared
+  Statement *GetStatement(StatementType type);
+
+  // Runs a statement whose parameters have been bound and resets it for the
+  // next use
+  //
+  // statement: The statement
+  // action: Description of the statement for error messages
+  //
+  // Returns true if successfull, else false
+  bool Step(Statement *statement, const std::string &action);
+
+  // Applies the settings of a profile to the open database
+  //
+  // profile: The settings
+  void ApplyProfile(const DBProfile &profile);
+
+  // Runs a statement without parameters
+  //
+  // cmd: The statement
+  //
+  // Returns true if successfull, else false
+  bool Execute(std::string cmd);
+
+  // Runs a query which returns a single integer
+  //
+  // cmd: The query
+  // value: Receives the first column of the first row
+  //
+  // Returns true if the query returned a row, else false
+  bool QueryInt(const std::string &cmd, int64_t *value);
+
   sqlite3 *db;         // Pointer to the open database
+  Statement statements[STMT_COUNT];  // Prepared statements
+  int64_t campaign = 0;  // Id of the campaign of this client, 0 before the first call
+  bool campaign_uncommitted = false;  // True if the campaign was started in the open transaction
+  bool ready = false;  // True if the database is open and has the current schema
   std::string path;    // Path to the database
 };
 
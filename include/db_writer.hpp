@@ -0,0 +1,111 @@
+// Copyright 2020 Barger M., Knoll M., Kofler L.
+#ifndef INCLUDE_DB_WRITER_HPP_
+#define INCLUDE_DB_WRITER_HPP_
+
+#include <condition_variable> // NOLINT
+#include <cstdint>
+#include <mutex> // NOLINT
+#include <string>
+#include <thread> // NOLINT
+#include <vector>
+
+#include "db_client.hpp"
+
+// Maximum time a change waits before it is committed in milliseconds
+#define DB_WRITER_INTERVAL_MS 500
+// Number of queued changes which are committed at once without waiting
+#define DB_WRITER_BATCH_ROWS 256
+// Number of transactions tried for a batch before its changes are dropped
+#define DB_WRITER_MAX_ATTEMPTS 3
+
+// Single writer of the database. Any number of threads post changes, which
+// are queued and applied by one thread in grouped transactions. A transaction
+// is committed as soon as DB_WRITER_BATCH_ROWS changes are queued or the
+// oldest change has waited DB_WRITER_INTERVAL_MS, so the database is synced
+// once per batch instead of once per change.
+//
+// The changes are applied in the order they were posted. A transaction takes
+// the write lock when it starts, so a locked database is waited for once per
+// batch. If a transaction can't be started or committed, it is rolled back
+// and the batch is tried again together with the changes posted meanwhile.
+// After DB_WRITER_MAX_ATTEMPTS failed transactions its changes are logged as
+// lost.
+class DBWriter {
+ public:
+  // Constructor, opens the database and starts the writer thread
+  //
+  // path: Path to the database
+  // profile: Settings of the database connection
+  // interval_ms: Maximum time a change waits before it is committed
+  // batch_rows: Number of changes which are committed without waiting
+  DBWriter(std::string path, const DBProfile &profile = DBProfile(), int interval_ms = DB_WRITER_INTERVAL_MS,
+           size_t batch_rows = DB_WRITER_BATCH_ROWS);
+
+  // Destructor, commits all queued changes and stops the writer thread
+  ~DBWriter();
+
+  // See DBClient::IsOpen(), nothing is written if it returns false
+  bool IsOpen();
+
+  // See DBClient::WriteRecord()
+  void WriteRecord(const CallRecord &record);
+
+  // See DBClient::WriteRecording()
+  void WriteRecording(std::string path, CallStatus status, int dev_type, int duration, double analysis_ms);
+
+  // Blocks until all changes posted so far have been committed or dropped
+  void Flush();
+
+  // Returns the number of committed transactions
+  uint64_t GetTransactionCount();
+
+  // Returns the number of changes which have been written and committed
+  uint64_t GetRowCount();
+
+ private:
+  enum OperationType {
+    OP_RECORD,
+    OP_RECORDING,
+  };
+
+  // A change, recordings use status, device type and duration of the record
+  struct Operation {
+    OperationType type;
+    CallRecord record;
+    std::string path;
+    double analysis_ms;
+  };
+
+  // Queues a change and wakes up the writer thread if a batch is complete
+  void Post(Operation operation);
+
+  // Commits batches until the writer is destroyed
+  void Run();
+
+  // Applies a batch in one transaction, called by the writer thread
+  //
+  // batch: The changes, in the order they were posted
+  // applied: Receives the number of committed changes
+  //
+  // Returns false if the transaction could not be started or committed
+  bool Apply(const std::vector<Operation> &batch, uint64_t *applied);
+
+  DBClient db;                            // Only used by the writer thread after it is opened
+  const int interval_ms;
+  const size_t batch_rows;
+
+  std::mutex mutex;                       // Guards all members below
+  std::condition_variable wake;           // Wakes up the writer thread
+  std::condition_variable committed_cond; // Signaled after each batch
+  std::vector<Operation> pending;         // Posted changes which have not been applied yet
+  uint64_t posted = 0;                    // Number of posted changes
+  uint64_t done = 0;                      // Number of posted changes the writer has finished
+  uint64_t rows = 0;                      // Number of committed changes
+  int flush_waiters = 0;                  // Threads waiting in Flush()
+  bool stop = false;                      // True when the writer thread should exit
+  uint64_t transactions = 0;              // Number of committed transactions
+
+  std::thread thread;                     // Thread which runs Run()
+};
+
+#endif  // INCLUDE_DB_WRITER_HPP_
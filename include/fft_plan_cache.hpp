@@ -0,0 +1,88 @@
+// Copyright 2020 Barger M., Knoll M., Kofler L.
+#ifndef INCLUDE_FFT_PLAN_CACHE_HPP_
+#define INCLUDE_FFT_PLAN_CACHE_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex> // NOLINT
+#include <string>
+#include <vector>
+
+#include "log.hpp"
+#include "./kiss_fft.h"
+#include "tools/kiss_fftr.h"
+
+// Process wide cache of kiss_fftr plans.
+//
+// A plan contains the twiddle factors, but also a scratch buffer which is
+// used by kiss_fftr(). So a plan can only be used by one thread at a time and
+// is lent out instead of shared. Returned plans are kept for the next thread
+// which needs a plan of the same size.
+class FFTPlanCache {
+ public:
+  // Returns a singleton object for the FFTPlanCache class
+  static FFTPlanCache* GetPlanCache();
+
+  // Borrows a plan for a real forward fft. A new plan is only computed if
+  // there is no unused plan of the given size.
+  //
+  // nfft: Size of the fft
+  kiss_fftr_cfg Acquire(int nfft);
+
+  // Returns a plan borrowed with Acquire() to the cache
+  //
+  // nfft: Size of the fft
+  // cfg: The plan
+  void Release(int nfft, kiss_fftr_cfg cfg);
+
+  // Returns the number of Acquire() calls which reused a cached plan
+  uint64_t GetHits();
+
+  // Returns the number of Acquire() calls which had to compute a new plan
+  uint64_t GetMisses();
+
+ private:
+  FFTPlanCache();
+  ~FFTPlanCache();
+
+  std::mutex mutex;                                   // Guards plans
+  std::map<int, std::vector<kiss_fftr_cfg>> plans;    // Unused plans by fft size
+  std::atomic<uint64_t> hits;                         // Number of reused plans
+  std::atomic<uint64_t> misses;                       // Number of computed plans
+};
+
+// Scratch buffers of one thread for ffts of one size
+struct FFTScratch {
+  kiss_fftr_cfg cfg;                  // Plan borrowed from the FFTPlanCache
+  std::vector<kiss_fft_cpx> fbuf;     // Result of the fft
+  std::vector<float> mag2buf;         // Squared magnitudes
+};
+
+// Per thread arena of fft scratch buffers. Analyzers borrow the buffers of the
+// thread they are running on for the duration of a single frame, so neither
+// plans nor buffers are allocated while analyzing.
+class FFTArena {
+ public:
+  // Returns the arena of the calling thread
+  static FFTArena* GetArena();
+
+  // Returns the scratch buffers for the given fft size. They are allocated
+  // the first time a size is used on this thread.
+  //
+  // nfft: Size of the fft
+  FFTScratch* GetScratch(int nfft);
+
+  // Returns the borrowed plans to the FFTPlanCache
+  ~FFTArena();
+
+ private:
+  FFTArena() = default;
+
+  std::map<int, FFTScratch> scratches;   // Scratch buffers by fft size
+};
+
+// Logs the hits and misses of the FFTPlanCache
+void LogPlanCacheStats();
+
+#endif  // INCLUDE_FFT_PLAN_CACHE_HPP_
@@ -0,0 +1,108 @@
+// Copyright 2020 Barger M., Knoll M., Kofler L.
+#ifndef INCLUDE_LIVE_ANALYSIS_HPP_
+#define INCLUDE_LIVE_ANALYSIS_HPP_
+
+#include <atomic>
+#include <condition_variable> // NOLINT
+#include <cstdint>
+#include <mutex> // NOLINT
+#include <thread> // NOLINT
+#include <vector>
+
+#include "audio_analyzer.hpp"
+#include "spsc_ring.hpp"
+
+// Capacity of the ring of a stream in samples, two seconds of audio
+#define LIVE_RING_SAMPLES 16384
+// Time a worker sleeps when none of its streams had new samples
+#define LIVE_ANALYSIS_IDLE_MS 10
+
+// Audio of one running call on its way from the RTP receiver to the
+// analyzer. The receiver writes decoded samples into the ring, a worker of
+// the LiveAnalysisPool feeds them into the analyzer.
+//
+// Streams are reused for one call after another, so a ring is only allocated
+// for every call which runs at the same time.
+class LiveStream {
+ public:
+  LiveStream();
+
+  // Prepares the stream for the next call, it must not be attached
+  //
+  // analyzer: Analyzer the samples of the call are fed into
+  void Reset(AudioAnalyzer *analyzer);
+
+  // Returns the ring the RTP receiver writes the decoded samples to
+  SPSCRing<int16_t> *GetRing();
+
+  // Returns the analyzer of the call
+  AudioAnalyzer *GetAnalyzer();
+
+  // Returns true as soon as the analyzer has classified the call as modem or
+  // fax. Afterwards the analyzer is not fed anymore and may be read.
+  bool HasVerdict();
+
+ private:
+  friend class LiveAnalysisPool;
+
+  // Feeds all queued samples into the analyzer, called by the consumer
+  //
+  // returns the number of samples consumed
+  size_t Drain();
+
+  SPSCRing<int16_t> ring;       // Decoded samples of the call
+  AudioAnalyzer *analyzer;      // Analyzer of the call
+  std::atomic<bool> verdict;    // Set by the consumer when the analyzer has a verdict
+  int worker;                   // Index of the worker the stream is attached to
+};
+
+// Workers which analyze the audio of all running calls. Every stream is
+// consumed by exactly one worker while it is attached, so its ring has a
+// single consumer.
+class LiveAnalysisPool {
+ public:
+  // Constructor, starts the workers
+  //
+  // workers: Number of worker threads
+  explicit LiveAnalysisPool(int workers);
+
+  // Destructor, stops the workers. All streams have to be detached.
+  ~LiveAnalysisPool();
+
+  // Hands a stream to the worker with the fewest streams
+  //
+  // stream: Stream of a call which is about to start
+  void Attach(LiveStream *stream);
+
+  // Takes a stream back from its worker. Samples which are still queued are
+  // fed into the analyzer by the calling thread.
+  //
+  // stream: An attached stream
+  void Detach(LiveStream *stream);
+
+  // Returns the highest fill level of the ring of any detached stream
+  size_t GetMaxFill();
+
+  // Returns the number of samples dropped by all detached streams because
+  // their rings were full
+  uint64_t GetOverflow();
+
+ private:
+  struct Worker {
+    std::mutex mutex;                   // Guards streams, held while they are drained
+    std::vector<LiveStream *> streams;  // Streams consumed by this worker
+  };
+
+  // Drains the streams of a worker until the pool is destroyed
+  void Run(Worker *worker);
+
+  std::vector<Worker> workers;
+  std::vector<std::thread> threads;
+  std::mutex stop_mutex;                // Guards stop
+  std::condition_variable stop_cond;    // Signaled when stop is set
+  bool stop = false;                    // True when the workers should exit
+  std::atomic<size_t> max_fill;         // Highest fill level of a ring in samples
+  std::atomic<uint64_t> overflow;       // Dropped samples
+};
+
+#endif  // INCLUDE_LIVE_ANALYSIS_HPP_
@@ -6,6 +6,7 @@
 #include <iostream>
 #include <fstream>
 #include <cstdarg>
+#include <mutex> // NOLINT
 #include <string>
 
 typedef enum {
@@ -42,6 +43,8 @@ class Logger {
   static const char* file_name;
   // Log file stream object
   static std::ofstream log_file;
+  // Serializes writes of concurrent threads
+  static std::mutex log_mutex;
   // Singelton Logger class object pointer
   static Logger* instance;
   // Converts LogLevelEnum to String for Logging
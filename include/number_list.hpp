@@ -0,0 +1,52 @@
+// Copyright 2020 Barger M., Knoll M., Kofler L.
+#ifndef INCLUDE_NUMBER_LIST_HPP_
+#define INCLUDE_NUMBER_LIST_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// List of numbers to wardial. Number ranges are stored as first number,
+// count and width, and the numbers are only formatted when requested, so the
+// size of the list does not depend on the size of the ranges.
+class NumberList {
+ public:
+  // Appends a single number, it is kept as written
+  //
+  // number: number to append
+  void AddNumber(const std::string &number);
+
+  // Appends all numbers of a range
+  //
+  // first: first number of the range
+  // last: last number of the range, not smaller than first
+  // width: numbers shorter than width are padded with leading zeros
+  void AddRange(int64_t first, int64_t last, size_t width);
+
+  // Returns the number of numbers in the list
+  size_t Size() const;
+
+  // Returns true if the list contains no numbers
+  bool Empty() const;
+
+  // Returns the number at a position
+  //
+  // index: position of the number, smaller than Size()
+  std::string At(size_t index) const;
+
+ private:
+  struct Entry {
+    size_t offset;          // Position of the first number of this entry in the list
+    int64_t first;          // First number of a range
+    size_t count;           // Count of numbers in this entry
+    size_t width;           // Width for zero padding
+    bool range;             // True if this entry is a range
+    std::string literal;    // Number of a single number entry
+  };
+
+  std::vector<Entry> entries;
+  size_t number_count = 0;
+};
+
+#endif  //  INCLUDE_NUMBER_LIST_HPP_
@@ -0,0 +1,112 @@
+// Copyright 2020 Barger M., Knoll M., Kofler L.
+#ifndef INCLUDE_REGISTRATION_MANAGER_HPP_
+#define INCLUDE_REGISTRATION_MANAGER_HPP_
+
+#include <osip2/osip.h>
+#include <osipparser2/osip_parser.h>
+#include <eXosip2/eXosip.h>
+
+#include <atomic>
+#include <condition_variable> // NOLINT
+#include <mutex> // NOLINT
+#include <string>
+#include <thread> // NOLINT
+
+#include "log.hpp"
+
+// Lifetime of a registration in seconds
+#define REGISTRATION_EXPIRY 300
+// Seconds before the expiry at which the registration is refreshed
+#define REGISTRATION_REFRESH_MARGIN 60
+// Seconds between the attempts to refresh a lost registration
+#define REGISTRATION_RETRY_INTERVAL 10
+// Failed attempts in a row after which a lost registration is given up
+#define REGISTRATION_MAX_RETRIES 6
+
+// Registers one account at the SIP provider and keeps the registration alive.
+// The account is registered once, a background thread refreshes it before it
+// expires. All calls share the registration state.
+class RegistrationManager {
+ public:
+  // Constructor
+  //
+  // context: eXosip context used to send the REGISTER messages
+  // username: SIP username
+  // password: SIP password
+  // uri: The SIP Trunk uri of your provider
+  RegistrationManager(eXosip_t *context, std::string username, std::string password, std::string uri);
+
+  // Destructor, stops refreshing the registration
+  ~RegistrationManager();
+
+  // Registers at the SIP provider and starts refreshing the registration.
+  // If Authentication is requred the credentials will be used in a second step
+  //
+  // Returns true if successfull, else false
+  bool Register();
+
+  // Removes the registration at the SIP provider
+  void Unregister();
+
+  // Returns true if the account is currently registered
+  bool IsRegistered();
+
+  // Waits until a lost registration has been refreshed. Gives up after
+  // REGISTRATION_MAX_RETRIES failed attempts in a row or when the
+  // registration is removed.
+  //
+  // cancel: Stops waiting when it is set, may be set by a signal handler
+  //
+  // Returns true if the account is registered
+  bool WaitForRegistration(const std::atomic<bool> &cancel);
+
+  // Processes a registration event, called by the event thread
+  //
+  // event: A EXOSIP_REGISTRATION_SUCCESS or EXOSIP_REGISTRATION_FAILURE event
+  void OnEvent(eXosip_event_t *event);
+
+  // Set a new timeout value for answers to REGISTER messages
+  //
+  // timeout: new value in seconds
+  void SetTimeout(int timeout);
+
+ private:
+  // Sends a REGISTER message for the existing registration and waits for
+  // the answer
+  //
+  // expires: requested lifetime in seconds, 0 to unregister
+  // err_msg: Error message which is to displayed if no answer arrives
+  //
+  // Returns true if the provider accepted the message
+  bool Update(int expires, std::string err_msg);
+
+  // Waits for the next final answer to a REGISTER message
+  //
+  // seen: Count of answers before the message was sent
+  // err_msg: Error message which is to displayed if no answer arrives
+  //
+  // Returns true if the registration succeeded
+  bool WaitForAnswer(int seen, std::string err_msg);
+
+  // Refreshes the registration until the manager is destroyed
+  void RefreshLoop();
+
+  eXosip_t *context;            // eXosip context
+  std::string server_uri;       // URI of the SIP provider
+  std::string username;         // SIP Username
+  std::string password;         // SIP Password
+  int reg_id;                   // Registration ID of the SIP session
+  int timeout;                  // Timeout for answers to REGISTER messages in seconds
+
+  std::atomic<bool> registered; // True if registered with the SIP provider
+  std::mutex reg_mutex;         // Serializes REGISTER transactions
+  std::mutex mutex;             // Guards the fields below
+  std::condition_variable cond; // Signals answers, refreshes and the stop request
+  int answers;                  // Count of final answers received
+  bool last_success;            // Result of the last final answer
+  int failures;                 // Failed refreshes in a row
+  bool stop;                    // True when the refresh thread should stop
+  std::thread refresh_thread;   // Thread which runs RefreshLoop()
+};
+
+#endif  // INCLUDE_REGISTRATION_MANAGER_HPP_
@@ -9,8 +9,16 @@
 #include <string>
 #include <vector>
 #include "log.hpp"
+#include "alaw.hpp"
+#include "spsc_ring.hpp"
+#include "rtp_runtime.hpp"
 
+// Number of bytes of a PCMA stream per second
+#define RTP_BYTES_PER_SECOND 8000
 
+// RTP session of a single call. The shared oRTP state is owned by RTPRuntime.
+// If the RTP engine of the runtime has been started, the stream is received
+// by the engine instead of an oRTP session.
 class RTPClient {
  public:
   // Constructor
@@ -19,7 +27,10 @@ class RTPClient {
   // local_port: The local port which has been randomly chosen
   // payload_type: The Type of the payload as specified by SDP
   // file_name: The name of the output file. If none is given the data won't be saved
-  RTPClient(std::string server_uri, int *local_port, int payload_type, std::string file_name);
+  // max_duration_ms: Maximum duration of the call, the buffer for the raw
+  // data is reserved for it when the transfer starts
+  RTPClient(std::string server_uri, int *local_port, int payload_type, std::string file_name,
+            double max_duration_ms);
 
   // Destructor
   ~RTPClient();
@@ -33,15 +44,32 @@ class RTPClient {
   void SendData();
 
   // Receive and save all RTP packets in the queue
-  void ReceiveAll();
+  //
+  // ring: If not null, every received payload is decoded into this ring
+  //
+  // returns the number of received bytes
+  int ReceiveAll(SPSCRing<int16_t> *ring = nullptr);
 
-  // Get raw data vector
+  // Moves the received raw data out of the client
   //
   // returns a vector containing the received raw data
-  std::vector<int8_t> GetRawData();
+  std::vector<int8_t> TakeRawData();
+
+  // Returns the packet counters of the call
+  RTPStreamStats GetStats();
 
  private:
-  RtpSession *session;          // RTP Session
+  // Writes the raw data received since offset to the file and decodes it
+  // into the ring
+  //
+  // offset: Size of the raw data before the new payload was appended
+  // ring: If not null, the payload is decoded into this ring
+  void Process(size_t offset, SPSCRing<int16_t> *ring);
+
+  RtpSession *session;          // RTP Session, nullptr if the engine is used
+  RTPEngine *engine;            // RTP engine of the runtime, nullptr if oRTP is used
+  RTPStream *stream;            // Stream of the engine
+  RTPStreamStats stats;         // Packet counters of the oRTP session
 
   std::string server_uri;       // URI of the remote server
   std::string file_name;        // Output file name
@@ -50,6 +78,8 @@ class RTPClient {
   int remote_port;              // Remote RTP port
   int payload_type;             // Payload type
   int recv_ts;                  // Timestamp of the next packet to receive
+  double max_duration_ms;       // Maximum duration of the call
+  size_t bytes_received;        // Number of payload bytes received
   bool active;                  // States if the RTP client is active and listening
   bool save_data;               // Indicates if data is to be saved
   const int pdu_size = 160;     // Size of the data of a single PCMA encoded PDU
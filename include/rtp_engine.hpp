@@ -0,0 +1,133 @@
+// Copyright 2020 Barger M., Knoll M., Kofler L.
+#ifndef INCLUDE_RTP_ENGINE_HPP_
+#define INCLUDE_RTP_ENGINE_HPP_
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+
+#include <atomic>
+#include <cstdint>
+#include <mutex> // NOLINT
+#include <string>
+#include <thread> // NOLINT
+#include <unordered_set>
+#include <vector>
+
+// Number of datagrams read with a single recvmmsg() call
+#define RTP_BATCH_SIZE 32
+// Largest datagram which is accepted
+#define RTP_MAX_PACKET_SIZE 1500
+// Maximum time the engine thread blocks in epoll_wait() in milliseconds
+#define RTP_ENGINE_WAIT_MS 100
+
+// Packet counters of a single stream
+struct RTPStreamStats {
+  uint64_t packets = 0;         // Accepted packets
+  uint64_t bytes = 0;           // Accepted payload bytes
+  uint64_t lost = 0;            // Packets missing in the sequence numbers
+  uint64_t dropped = 0;         // Malformed packets, wrong payload type or foreign SSRC
+};
+
+// Receive side of the RTP stream of one call. Owned by the RTPEngine, which
+// appends the payload of every accepted packet until the stream is closed.
+class RTPStream {
+ public:
+  // Moves all payload received since the last call to the end of out
+  //
+  // out: Vector the payload is appended to
+  //
+  // returns the number of bytes appended
+  size_t Take(std::vector<int8_t> *out);
+
+  // Returns the packet counters of the stream
+  RTPStreamStats GetStats();
+
+  // Returns the local UDP port of the stream
+  int GetLocalPort() const;
+
+ private:
+  friend class RTPEngine;
+
+  RTPStream(int fd, int local_port, int payload_type);
+
+  // Adds a packet, called by the engine thread
+  //
+  // packet: The whole RTP packet
+  // len: Length of the packet in bytes
+  void Deliver(const uint8_t *packet, size_t len);
+
+  const int fd;                 // Non-blocking UDP socket
+  const int local_port;         // Local RTP port
+  const int payload_type;       // Expected payload type
+  sockaddr_in remote;           // Address the keepalive packet is sent to
+
+  std::mutex mutex;             // Guards all members below
+  std::vector<int8_t> pending;  // Payload which has not been taken yet
+  bool have_ssrc = false;       // True as soon as the first packet has been accepted
+  uint32_t ssrc = 0;            // SSRC of the stream, later packets must match it
+  uint16_t next_seq = 0;        // Expected sequence number of the next packet
+  RTPStreamStats stats;         // Packet counters
+};
+
+// Receives the RTP streams of all calls on one thread. Every stream has its
+// own non-blocking UDP socket, all sockets are registered with a single epoll
+// instance. Ready sockets are drained in batches with recvmmsg() and the
+// packets are demultiplexed by local port and SSRC.
+//
+// Unlike oRTP there is no jitter buffer, payload is stored in the order it
+// arrives.
+class RTPEngine {
+ public:
+  // Constructor, starts the engine thread
+  RTPEngine();
+
+  // Destructor, stops the engine thread and closes all streams
+  ~RTPEngine();
+
+  // Opens a stream on a random local port
+  //
+  // payload_type: Payload type of accepted packets as specified by SDP
+  //
+  // returns the stream, or nullptr if no socket could be opened
+  RTPStream *Open(int payload_type);
+
+  // Sends an empty RTP packet to the remote side, so the remote side and
+  // NATs in between learn our address
+  //
+  // stream: A stream returned by Open()
+  // host: Remote host name or address
+  // port: Remote RTP port
+  //
+  // returns true if successfull, else false
+  bool Connect(RTPStream *stream, std::string host, int port);
+
+  // Closes a stream. It must not be used afterwards.
+  //
+  // stream: A stream returned by Open()
+  void Close(RTPStream *stream);
+
+  // Returns the number of open streams
+  size_t GetStreamCount();
+
+ private:
+  // Waits for ready sockets until the engine is destroyed
+  void Loop();
+
+  // Reads all queued datagrams of a stream
+  void Drain(RTPStream *stream);
+
+  int epoll_fd;                 // epoll instance of all sockets
+  std::atomic<bool> running;    // False when the engine thread should stop
+  std::thread thread;           // Thread which runs Loop()
+
+  std::mutex mutex;             // Guards streams, held while packets are delivered
+  std::unordered_set<RTPStream *> streams;  // All open streams
+
+  // Receive buffers of the engine thread
+  mmsghdr messages[RTP_BATCH_SIZE];
+  iovec iovecs[RTP_BATCH_SIZE];
+  uint8_t buffers[RTP_BATCH_SIZE][RTP_MAX_PACKET_SIZE];
+};
+
+#endif  // INCLUDE_RTP_ENGINE_HPP_
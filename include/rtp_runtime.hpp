@@ -0,0 +1,66 @@
+// Copyright 2020 Barger M., Knoll M., Kofler L.
+#ifndef INCLUDE_RTP_RUNTIME_HPP_
+#define INCLUDE_RTP_RUNTIME_HPP_
+
+#include <ortp/ortp.h>
+
+#include <atomic>
+#include <mutex> // NOLINT
+#include <string>
+
+#include "rtp_engine.hpp"
+
+// Singleton which owns the process-global state of oRTP. The library and its
+// scheduler are initialized once, RTP sessions of all calls are created and
+// destroyed through the runtime. It also owns the optional RTPEngine which
+// replaces the oRTP sessions when it has been started.
+class RTPRuntime {
+ public:
+  // Returns the runtime, oRTP is initialized on the first call
+  static RTPRuntime* GetRuntime();
+
+  // Shuts down oRTP if it has been initialized. Must be called after all
+  // sessions have been destroyed.
+  static void Shutdown();
+
+  // Creates an RTP session
+  //
+  // server_uri: URI of the remote server
+  // remote_port: Remote RTP port
+  // payload_type: The Type of the payload as specified by SDP
+  //
+  // Returns the new session
+  RtpSession *CreateSession(std::string server_uri, int remote_port, int payload_type);
+
+  // Destroys a session created by CreateSession()
+  //
+  // session: The session to destroy
+  void DestroySession(RtpSession *session);
+
+  // Returns the number of sessions which have not been destroyed yet
+  int GetSessionCount();
+
+  // Starts the RTP engine, streams of calls started afterwards are received
+  // by it instead of oRTP
+  void StartEngine();
+
+  // Returns the RTP engine, nullptr if it has not been started
+  RTPEngine *GetEngine();
+
+ private:
+  // Constructor, initializes oRTP and its scheduler
+  RTPRuntime();
+  // Destructor, shuts down oRTP
+  ~RTPRuntime();
+
+  // Singleton RTPRuntime class object pointer
+  static RTPRuntime* instance;
+  // Guards creation and destruction of the instance
+  static std::mutex instance_mutex;
+  // Number of active sessions
+  std::atomic<int> sessions;
+  // Optional RTP engine
+  std::atomic<RTPEngine *> engine;
+};
+
+#endif  // INCLUDE_RTP_RUNTIME_HPP_
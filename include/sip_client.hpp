@@ -16,69 +16,138 @@
 #include <iostream>
 #include <chrono> // NOLINT
 #include <cstring>
+#include <mutex> // NOLINT
+#include <functional>
 #include <boost/algorithm/string.hpp>
 
 #include "log.hpp"
 #include "rtp_client.hpp"
-
-class SIPClient {
+#include "live_analysis.hpp"
+#include "call_manager.hpp"
+
+// Interval in which the RTP stream of a recorded call is read in milliseconds
+#define RTP_POLL_INTERVAL_MS 100
+
+// States of a call. A call starts in CALL_INVITING and always passes
+// CALL_TERMINATING before it becomes CALL_IDLE again.
+typedef enum {
+  CALL_IDLE,          // No active call
+  CALL_INVITING,      // INVITE has been sent
+  CALL_PROCEEDING,    // Remote side is processing the INVITE
+  CALL_RINGING,       // Remote side is ringing
+  CALL_ANSWERED,      // Remote side picked up
+  CALL_RECORDING,     // RTP stream is being recorded
+  CALL_TERMINATING,   // Call is being ended
+} CallState;
+
+// Reasons for the end of a call
+typedef enum {
+  END_NONE,           // Call has not ended
+  END_REJECTED,       // Remote side rejected the INVITE
+  END_NO_ANSWER,      // Timeout before the call has been answered
+  END_NO_MEDIA,       // Answer without a PCMA stream
+  END_CLOSED,         // Remote side hung up
+  END_DURATION,       // Maximum call duration has been reached
+  END_VERDICT,        // Line type has been detected while recording
+} CallEnd;
+
+class SIPClient;
+
+// Called on the event thread of the call manager when a call has ended. The
+// client is not used afterwards, so the callback may delete it.
+typedef std::function<void(SIPClient *call)> CallCompletion;
+
+// Places a single call through the shared CallManager. Invite() only sends
+// the INVITE, afterwards the call is a state machine which is driven by its
+// SIP events and timers on the event thread of the call manager. Events and
+// timers only select the next state, entering a state runs its actions: the
+// answer starts the RTP session, the recording schedules its timers and the
+// termination hangs up and reports the ended call to a callback. No thread
+// waits for the call while it is running.
+class SIPClient : public CallHandler {
  public:
   // Constructor
   //
-  // username: SIP username
-  // password: SIP password
-  // uri: The SIP Trunk uri of your provider
-  // port: The local SIP port
-  SIPClient(std::string username, std::string password, std::string uri, int port, int threadid);
+  // manager: The call manager which owns the eXosip context
+  explicit SIPClient(CallManager *manager);
 
-  // Destructor
+  // Destructor, the call must have been reported as ended or not been started
   ~SIPClient();
 
-  // Register a new SIP Session with the set SIP provider
-  // If Authentication is requred the credentials will be used in a second step
-  //
-  // Returns true if successfull, else false
-  bool Register();
-
-  // Invite a SIP client to a call after a successfull registration
+  // Invite a SIP client to a call after a successfull registration. Returns
+  // as soon as the INVITE has been sent.
   //
   // tel_nr: Telephone number which is to be called
   // max_call_duration: Maximum call duration in milliseconds
   // save_data: Specifies if call data is to be saved to the disk
-  // call_duration: Pointer to an int where the call duration is to be saved
+  // live: If not null, the audio is passed to this attached stream while the
+  //       call is running and the call is terminated as soon as its analyzer
+  //       reached a verdict
+  // done: Called when the call has ended, only if true is returned
+  //
+  // Returns true if the call has been started, else false
+  bool Invite(std::string tel_nr, double max_call_duration, bool save_data, LiveStream *live, CallCompletion done);
+
+  // Processes an event of the call, called by the event thread
+  //
+  // event: The event, it is freed by the call manager afterwards
+  void OnEvent(eXosip_event_t *event) override;
+
+  // Processes an expired timer of the call, called by the event thread
   //
-  // Returns true if successfull, else false
-  bool Invite(std::string tel_nr, double max_call_duration, bool save_data, int *call_duration);
+  // id: Id of the timer
+  void OnTimeout(TimingWheel::TimerId id) override;
 
-  // Set a new default timeout value for events
+  // Set a new timeout value for the INVITE, proceeding and ringing states
   //
   // timeout: new value in seconds
   void SetTimeout(int timeout);
 
-  // Get raw PCMA encoded Data from call
+  // Returns the called number
+  std::string GetNumber();
+
+  // Returns true if the call has been answered and recorded
+  bool IsAnswered();
+
+  // Returns the reason for the end of the call
+  CallEnd GetEnd();
+
+  // Returns the duration of the recording in seconds
+  int GetCallDuration();
+
+  // Moves the raw PCMA encoded data of the ended call out of the client
   //
   // Returns a vector containing the call data
-  std::vector<int8_t> GetCallData();
+  std::vector<int8_t> TakeCallData();
 
  private:
-  // Terminates the call if it is marked as active
-  void TerminateCall();
-
-  // Wait for a specific event to hapen. This method immediately returns control
-  // back to the callee when the specified event occurs and stores the event in
-  // this->last_event.
-  //
-  // event_type: Event to wait for
-  // err_msg: Error message which is to displayed if the event does not occur
-  // timeout_s: Timeout value in seconds which only applies to this method
-  // timeout_ms: Timeout value in milliseconds which only applies to this method
+  // Reads the RTP stream and hangs up if the line type is already known.
+  // The mutex has to be held.
+  void Poll();
+
+  // Action of CALL_ANSWERED, starts the RTP session and moves on to
+  // CALL_RECORDING, or to CALL_TERMINATING without a usable stream. The mutex
+  // has to be held.
+  void StartRecording();
+
+  // Action of CALL_TERMINATING, collects the recording, sends the BYE, stops
+  // routing the events of the call and moves on to CALL_IDLE. The mutex has
+  // to be held.
+  void Terminate();
+
+  // Reports the ended call to the callback once the call is in CALL_IDLE,
+  // the client may be deleted afterwards. The mutex must not be held.
+  void Complete();
+
+  // Changes the state of the call, cancels the timers of the old state and
+  // runs the actions of the new one. The mutex has to be held.
   //
-  // Returns true if the event has occured, false if not
-  bool WaitForEvent(eXosip_event_type_t event_type, std::string err_msg, int timeout_s, int timeout_ms);
+  // state: new state
+  // end: reason if the call ends
+  void SetState(CallState state, CallEnd end = END_NONE);
 
-  // See WaitForEvent(eXpsip_event_type_t event_type, std::string err_msg)
-  // The difference is, that this method uses the set timeout value
-  bool WaitForEvent(eXosip_event_type_t event_type, std::string err_msg);
+  // Returns a string representation for the given state
+  std::string StateToString(CallState state);
 
   // Parse a SDP response to an SIP Invite.
   // This response contains the port used for the rtp connection
@@ -93,21 +162,33 @@ class SIPClient {
   // Returns a string representation for the given event.
   std::string EventToString(eXosip_event_type event);
 
-  eXosip_t *context;            // eXosip context
-  eXosip_event_t *last_event;   // Last event which has been processed
+  CallManager *manager;         // Call manager which routes the events
+  eXosip_t *context;            // eXosip context of the call manager
 
   std::string server_uri;       // URI of the SIP provider
   std::string username;         // SIP Username
-  std::string password;         // SIP Password
-  osip_message_t *reg_msg;      // The original registration message
-  int reg_id;                   // Registration ID of the SIP session
-  int call_id;                  // Call ID of the active call
-  int dial_id;                  // Dial ID of the active call
-  bool registered;              // True if registered with a SIP provider
-  std::vector<int8_t> call_data;        // Raw pcma encoded data of the last call
-
-  int timeout;                  // Default timeout value for events in seconds
-  int threadid;
+  std::string tel_nr;           // Called number
+  int call_id;                  // Call ID of the call
+
+  // State of the call, updated by the event thread
+  std::mutex mutex;             // Guards the state
+  CallState state;              // Current state of the call
+  CallEnd end;                  // Reason for the end of the call
+  TimingWheel::TimerId timer;   // Timer of the current state, 0 if none
+  TimingWheel::TimerId poll_timer;  // Timer which reads the RTP stream, 0 if none
+  double max_call_duration;     // Time limit of the recording in milliseconds
+  int dial_id;                  // Dial ID of the call
+  int rtp_remote_port;          // RTP port of the remote side, -1 if unknown
+  CallCompletion done;          // Called when the call has ended
+
+  RTPClient *rtp;               // RTP session of the call, nullptr if none
+  LiveStream *live;             // Stream of the live analysis, nullptr if none
+  bool answered;                // True if the recording has been started
+  std::chrono::steady_clock::time_point begin;  // Start of the recording
+  int call_duration;            // Duration of the recording in seconds
+  std::vector<int8_t> call_data;        // Raw pcma encoded data of the call
+
+  int timeout;                  // Timeout of the states before the answer in seconds
 };
 
 #endif  // INCLUDE_SIP_CLIENT_HPP_
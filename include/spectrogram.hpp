@@ -0,0 +1,48 @@
+// Copyright 2020 Barger M., Knoll M., Kofler L.
+#ifndef INCLUDE_SPECTROGRAM_HPP_
+#define INCLUDE_SPECTROGRAM_HPP_
+
+#include <cstddef>
+#include <vector>
+
+// Power spectra of consecutive frames. All frames share one frequency axis
+// and the power of all frames is stored in a single matrix with one row per
+// frame.
+class Spectrogram {
+ public:
+  // Constructor
+  //
+  // frequencies: frequency of each bin, has to outlive the spectrogram
+  // bins: number of bins per frame
+  Spectrogram(const float *frequencies, int bins);
+
+  // Appends the power spectrum of a frame
+  //
+  // power: power of each bin in dB
+  void AddFrame(const float *power);
+
+  // Removes all frames
+  void Clear();
+
+  // Returns the number of frames
+  size_t GetFrameCount() const;
+
+  // Returns the number of bins per frame
+  int GetBinCount() const;
+
+  // Returns the frequency of a bin
+  float GetFrequency(int bin) const;
+
+  // Returns the power spectrum of a frame
+  const float *GetFrame(size_t frame) const;
+
+  // Returns the power of a bin in a frame
+  float GetPower(size_t frame, int bin) const;
+
+ private:
+  const float *frequencies;     // Frequency axis shared by all frames
+  int bins;                     // Number of bins per frame
+  std::vector<float> power;     // Power of all frames, frame after frame
+};
+
+#endif  // INCLUDE_SPECTROGRAM_HPP_
@@ -0,0 +1,173 @@
+// Copyright 2020 Barger M., Knoll M., Kofler L.
+#ifndef INCLUDE_SPSC_RING_HPP_
+#define INCLUDE_SPSC_RING_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Size of a cache line, keeps the positions of producer and consumer apart
+#define SPSC_RING_ALIGN 64
+
+// Lock-free single producer, single consumer ring buffer with a fixed
+// capacity.
+//
+// Exactly one thread may write and one other thread may read at the same
+// time. Nothing is allocated after construction. Elements which do not fit
+// are dropped and counted, the producer never blocks.
+template <typename T>
+class SPSCRing {
+ public:
+  // Constructor
+  //
+  // capacity: Minimum number of elements, rounded up to a power of two
+  explicit SPSCRing(size_t capacity) {
+    size_t size = 1;
+    while (size < capacity) {
+      size <<= 1;
+    }
+    buffer.resize(size);
+    mask = size - 1;
+  }
+
+  SPSCRing(const SPSCRing&) = delete;
+  SPSCRing& operator=(const SPSCRing&) = delete;
+
+  // Producer: Copies elements into the ring, elements which do not fit are
+  // dropped
+  //
+  // data: Elements to append
+  // len: Number of elements
+  //
+  // return: number of elements written
+  size_t Write(const T *data, size_t len) {
+    size_t written = 0;
+    T *span;
+    size_t space;
+    while (written < len && (space = Reserve(&span)) > 0) {
+      size_t n = std::min(space, len - written);
+      std::copy(data + written, data + written + n, span);
+      Commit(n);
+      written += n;
+    }
+    Drop(len - written);
+    return written;
+  }
+
+  // Producer: Returns the contiguous free space at the write position. The
+  // elements are published with Commit().
+  //
+  // data: Receives the address of the free space
+  //
+  // return: number of elements which can be written to data
+  size_t Reserve(T **data) {
+    size_t write = head.load(std::memory_order_relaxed);
+    size_t read = tail.load(std::memory_order_acquire);
+    size_t space = buffer.size() - (write - read);
+    *data = &buffer[write & mask];
+    return std::min(space, buffer.size() - (write & mask));
+  }
+
+  // Producer: Publishes elements written to the space returned by Reserve()
+  //
+  // len: Number of elements, at most the value returned by Reserve()
+  void Commit(size_t len) {
+    size_t write = head.load(std::memory_order_relaxed) + len;
+    head.store(write, std::memory_order_release);
+    size_t fill = write - tail.load(std::memory_order_acquire);
+    if (fill > max_fill.load(std::memory_order_relaxed)) {
+      max_fill.store(fill, std::memory_order_relaxed);
+    }
+  }
+
+  // Producer: Counts elements which have been dropped because the ring was full
+  //
+  // len: Number of elements
+  void Drop(size_t len) {
+    if (len > 0) {
+      overflow.fetch_add(len, std::memory_order_relaxed);
+    }
+  }
+
+  // Consumer: Moves elements out of the ring
+  //
+  // data: Output buffer, has to be able to hold len elements
+  // len: Maximum number of elements
+  //
+  // return: number of elements read
+  size_t Read(T *data, size_t len) {
+    size_t read = 0;
+    const T *span;
+    size_t available;
+    while (read < len && (available = Peek(&span)) > 0) {
+      size_t n = std::min(available, len - read);
+      std::copy(span, span + n, data + read);
+      Consume(n);
+      read += n;
+    }
+    return read;
+  }
+
+  // Consumer: Returns the contiguous elements at the read position. They are
+  // released with Consume().
+  //
+  // data: Receives the address of the elements
+  //
+  // return: number of elements which can be read from data
+  size_t Peek(const T **data) {
+    size_t read = tail.load(std::memory_order_relaxed);
+    size_t write = head.load(std::memory_order_acquire);
+    *data = &buffer[read & mask];
+    return std::min(write - read, buffer.size() - (read & mask));
+  }
+
+  // Consumer: Releases elements returned by Peek()
+  //
+  // len: Number of elements, at most the value returned by Peek()
+  void Consume(size_t len) {
+    tail.store(tail.load(std::memory_order_relaxed) + len, std::memory_order_release);
+  }
+
+  // Empties the ring and clears the counters, neither producer nor consumer
+  // may be active
+  void Reset() {
+    head.store(0);
+    tail.store(0);
+    overflow.store(0);
+    max_fill.store(0);
+  }
+
+  // return: number of queued elements
+  size_t Size() const {
+    // The tail is loaded first, the head can only be ahead of it
+    size_t read = tail.load(std::memory_order_acquire);
+    return head.load(std::memory_order_acquire) - read;
+  }
+
+  // return: maximum number of queued elements
+  size_t GetCapacity() const {
+    return buffer.size();
+  }
+
+  // return: number of elements dropped because the ring was full
+  uint64_t GetOverflow() const {
+    return overflow.load(std::memory_order_relaxed);
+  }
+
+  // return: highest number of elements queued at the same time
+  size_t GetMaxFill() const {
+    return max_fill.load(std::memory_order_relaxed);
+  }
+
+ private:
+  std::vector<T> buffer;
+  size_t mask;
+  alignas(SPSC_RING_ALIGN) std::atomic<size_t> head{0};       // Next write position, only written by the producer
+  alignas(SPSC_RING_ALIGN) std::atomic<size_t> tail{0};       // Next read position, only written by the consumer
+  alignas(SPSC_RING_ALIGN) std::atomic<uint64_t> overflow{0};  // Dropped elements
+  std::atomic<size_t> max_fill{0};                            // High-water mark
+};
+
+#endif  // INCLUDE_SPSC_RING_HPP_
@@ -14,6 +14,7 @@
 #include "db_client.hpp"
 #include "audio_analyzer.hpp"
 #include "wardialer.hpp"
+#include "batch_analyzer.hpp"
 
 boost::program_options::variables_map vm;
 
@@ -0,0 +1,87 @@
+// Copyright 2020 Barger M., Knoll M., Kofler L.
+#ifndef INCLUDE_TIMING_WHEEL_HPP_
+#define INCLUDE_TIMING_WHEEL_HPP_
+
+#include <chrono> // NOLINT
+#include <cstdint>
+#include <functional>
+#include <mutex> // NOLINT
+#include <unordered_map>
+#include <vector>
+
+// Bits of the slot index of the lowest level, the other levels use TIMER_LEVEL_BITS
+#define TIMER_ROOT_BITS 8
+#define TIMER_LEVEL_BITS 6
+#define TIMER_LEVELS 4
+
+// Hierarchical timing wheel. Scheduling and cancelling a timer costs O(1), no
+// matter how many timers are pending. Timers are kept in the lowest level
+// whose range covers them and move to lower levels as their expiry comes
+// closer. With a tick of 20 ms the first level covers 5 s and all
+// levels together more than 12 days.
+class TimingWheel {
+ public:
+  typedef uint64_t TimerId;
+  typedef std::function<void(TimerId)> Callback;
+
+  // Constructor
+  //
+  // tick_ms: Resolution of the wheel in milliseconds
+  explicit TimingWheel(int tick_ms);
+
+  // Schedules a callback
+  //
+  // delay_ms: Time until the callback is run in milliseconds
+  // callback: Function which is run with the id of the timer when it expires
+  //
+  // Returns the id of the timer, it is never 0
+  TimerId Schedule(int delay_ms, Callback callback);
+
+  // Cancels a timer
+  //
+  // id: Id returned by Schedule()
+  //
+  // Returns true if the timer was pending
+  bool Cancel(TimerId id);
+
+  // Advances the wheel to the given time and runs the callbacks of all
+  // expired timers. The callbacks run on the calling thread.
+  //
+  // now: current time
+  void Advance(std::chrono::steady_clock::time_point now);
+
+  // Advances the wheel by a number of ticks and runs the callbacks of all
+  // expired timers
+  //
+  // ticks: number of ticks
+  void Tick(uint64_t ticks);
+
+  // Returns the number of pending timers
+  size_t Size();
+
+  // Returns the resolution of the wheel in milliseconds
+  int GetTickMs() const;
+
+ private:
+  struct Timer {
+    uint64_t expiry;                  // Tick at which the timer expires
+    Callback callback;                // Function to run
+  };
+
+  // Puts a timer into the slot which matches its expiry, the lock must be held
+  void Insert(TimerId id, uint64_t expiry);
+
+  // Moves the timers of the current slot of a level to lower levels, the
+  // lock must be held
+  void Cascade(int level);
+
+  const int tick_ms;
+  const std::chrono::steady_clock::time_point start;
+  uint64_t current = 0;               // Number of ticks processed so far
+  TimerId next_id = 1;
+  std::vector<std::vector<TimerId>> slots[TIMER_LEVELS];
+  std::unordered_map<TimerId, Timer> timers;  // All pending timers
+  std::mutex mutex;
+};
+
+#endif  // INCLUDE_TIMING_WHEEL_HPP_
@@ -3,21 +3,50 @@
 #define INCLUDE_WARDIALER_HPP_
 
 #include <thread> // NOLINT
+#include <algorithm>
+#include <atomic>
 #include <iostream>
 #include <string>
 #include <csignal>
 #include <vector>
 #include <iomanip>
 #include <chrono> // NOLINT
+#include <ctime>
+#include <condition_variable> // NOLINT
+#include <deque>
+#include <mutex> // NOLINT
 
 #include "wav.hpp"
 #include "audio_analyzer.hpp"
 #include "sip_client.hpp"
+#include "call_manager.hpp"
+#include "rtp_runtime.hpp"
 #include "argparse.hpp"
-#include "db_client.hpp"
+#include "db_writer.hpp"
+#include "bounded_queue.hpp"
+#include "live_analysis.hpp"
+
+// Maximum number of finished calls waiting for analysis. A call holds up to
+// 25 s of 8 kHz A-law samples, so the queue is limited to about 6 MB.
+#define ANALYSIS_QUEUE_CAPACITY 32
+
+// Maximum time an answered call is recorded in milliseconds
+#define MAX_CALL_DURATION_MS 25000
+
+// Number of threads which start calls. They only wait for a free slot and
+// the registration, the calls themselves run on the event thread of the call
+// manager, so -t limits the running calls and not the threads.
+#define DIAL_THREADS 4
+
+// Time a dial thread waits for a free slot before it checks for a signal in
+// milliseconds
+#define DIAL_WAIT_MS 100
 
 int Wardialer();
-void WardialThread(std::vector<std::string> numbers, int thread_id);
+void DialThread(int thread_id);
+void StartCall(CallRecord record);
+void CallEnded(SIPClient *client, CallRecord record, LiveStream *live, AudioAnalyzer *analyzer);
+void AnalysisThread();
 void dec_thread_counter();
 void inc_thread_counter();
 
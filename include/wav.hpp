@@ -10,6 +10,7 @@
 #include <iterator>
 
 #include "log.hpp"
+#include "alaw.hpp"
 
 // WAV Header
 #define WAV_HEADER_SIZE 44
@@ -34,6 +35,24 @@ struct WAV_HEADER {
   uint32_t data_block_len;
 };
 
+// Non-owning view of the samples of a Wav object. It is only valid as long as
+// the Wav object exists and no other file is read into it.
+class SampleView {
+ public:
+  SampleView(const int16_t *samples, size_t len) : samples(samples), len(len) {}
+
+  const int16_t *data() const { return samples; }
+  size_t size() const { return len; }
+  bool empty() const { return len == 0; }
+  const int16_t *begin() const { return samples; }
+  const int16_t *end() const { return samples + len; }
+  const int16_t &operator[](size_t idx) const { return samples[idx]; }
+
+ private:
+  const int16_t *samples;
+  size_t len;
+};
+
 class Wav {
  public:
   // Constructor
@@ -46,10 +65,13 @@ class Wav {
   // return: was extraction successful
   bool Read(std::string file_path);
 
-  bool Read(std::vector<int8_t> alaw_samples);
+  // Decodes PCMA encoded samples with a sample rate of 8000
+  //
+  // return: false if there are no samples
+  bool Read(const std::vector<int8_t> &alaw_samples);
 
-  // return: samples in the file
-  std::vector<int16_t> GetSamples();
+  // return: view of the samples in the file, no samples are copied
+  SampleView GetSamples() const;
 
   // return: sample rate
   uint GetSampleRate();
@@ -61,10 +83,15 @@ class Wav {
 
   double GetDuration();
 
+  // Decodes a single PCMA (A-law) encoded sample
+  //
+  // number: encoded sample
+  //
+  // return: 16 bit PCM sample
+  static int16_t DecodeAlawSample(int8_t number);
 
  private:
-  int16_t DecodeAlawSample(int8_t number);
-  void DecodeAlaw(std::vector<int8_t> alaw_samples);
+  void DecodeAlaw(const std::vector<int8_t> &alaw_samples);
 
   std::vector<int16_t> samples;
   std::string file_name;
@@ -0,0 +1,110 @@
+// Copyright 2020 Barger M., Knoll M., Kofler L.
+#include "alaw.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+void DecodeAlawScalar(const int8_t *alaw_samples, size_t len, int16_t *samples) {
+  for (size_t i = 0; i < len; i++) {
+    samples[i] = alaw_table.values[static_cast<uint8_t>(alaw_samples[i])];
+  }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+/*
+    For an exponent e > 0 a sample decodes to (2 * mantissa + 33) << (e - 1)
+    and for e = 0 to 2 * mantissa + 1. So the kernels calculate a base value
+    and a multiplier, which both fit into a byte and are looked up from the
+    exponent with pshufb, multiply them in 16 bit lanes and apply the sign.
+*/
+__attribute__((target("ssse3")))
+void DecodeAlawSSSE3(const int8_t *alaw_samples, size_t len, int16_t *samples) {
+  const __m128i xor_mask = _mm_set1_epi8(0x55);
+  const __m128i low_mask = _mm_set1_epi8(0x0F);
+  const __m128i exp_mask = _mm_set1_epi8(0x07);
+  const __m128i bias_tbl = _mm_setr_epi8(1, 33, 33, 33, 33, 33, 33, 33, 0, 0, 0, 0, 0, 0, 0, 0);
+  const __m128i mult_tbl = _mm_setr_epi8(1, 1, 2, 4, 8, 16, 32, 64, 0, 0, 0, 0, 0, 0, 0, 0);
+  const __m128i zero = _mm_setzero_si128();
+  size_t i = 0;
+
+  for (; i + 16 <= len; i += 16) {
+    __m128i x = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(alaw_samples + i)), xor_mask);
+    __m128i sign = _mm_cmplt_epi8(x, zero);
+    __m128i exponent = _mm_and_si128(_mm_srli_epi16(x, 4), exp_mask);
+    __m128i mantissa = _mm_and_si128(x, low_mask);
+    __m128i base = _mm_add_epi8(_mm_add_epi8(mantissa, mantissa), _mm_shuffle_epi8(bias_tbl, exponent));
+    __m128i mult = _mm_shuffle_epi8(mult_tbl, exponent);
+
+    __m128i lo = _mm_mullo_epi16(_mm_unpacklo_epi8(base, zero), _mm_unpacklo_epi8(mult, zero));
+    __m128i hi = _mm_mullo_epi16(_mm_unpackhi_epi8(base, zero), _mm_unpackhi_epi8(mult, zero));
+    __m128i sign_lo = _mm_unpacklo_epi8(sign, sign);
+    __m128i sign_hi = _mm_unpackhi_epi8(sign, sign);
+    lo = _mm_sub_epi16(_mm_xor_si128(lo, sign_lo), sign_lo);
+    hi = _mm_sub_epi16(_mm_xor_si128(hi, sign_hi), sign_hi);
+
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(samples + i), lo);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(samples + i + 8), hi);
+  }
+
+  DecodeAlawScalar(alaw_samples + i, len - i, samples + i);
+}
+
+__attribute__((target("avx2")))
+void DecodeAlawAVX2(const int8_t *alaw_samples, size_t len, int16_t *samples) {
+  const __m256i xor_mask = _mm256_set1_epi8(0x55);
+  const __m256i low_mask = _mm256_set1_epi8(0x0F);
+  const __m256i exp_mask = _mm256_set1_epi8(0x07);
+  const __m256i bias_tbl = _mm256_setr_epi8(1, 33, 33, 33, 33, 33, 33, 33, 0, 0, 0, 0, 0, 0, 0, 0,
+                                            1, 33, 33, 33, 33, 33, 33, 33, 0, 0, 0, 0, 0, 0, 0, 0);
+  const __m256i mult_tbl = _mm256_setr_epi8(1, 1, 2, 4, 8, 16, 32, 64, 0, 0, 0, 0, 0, 0, 0, 0,
+                                            1, 1, 2, 4, 8, 16, 32, 64, 0, 0, 0, 0, 0, 0, 0, 0);
+  size_t i = 0;
+
+  for (; i + 32 <= len; i += 32) {
+    __m256i x = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(alaw_samples + i)),
+                                 xor_mask);
+    __m256i sign = _mm256_cmpgt_epi8(_mm256_setzero_si256(), x);
+    __m256i exponent = _mm256_and_si256(_mm256_srli_epi16(x, 4), exp_mask);
+    __m256i mantissa = _mm256_and_si256(x, low_mask);
+    __m256i base = _mm256_add_epi8(_mm256_add_epi8(mantissa, mantissa), _mm256_shuffle_epi8(bias_tbl, exponent));
+    __m256i mult = _mm256_shuffle_epi8(mult_tbl, exponent);
+
+    // Widen each half to 16 bit lanes
+    __m256i lo = _mm256_mullo_epi16(_mm256_cvtepu8_epi16(_mm256_castsi256_si128(base)),
+                                    _mm256_cvtepu8_epi16(_mm256_castsi256_si128(mult)));
+    __m256i hi = _mm256_mullo_epi16(_mm256_cvtepu8_epi16(_mm256_extracti128_si256(base, 1)),
+                                    _mm256_cvtepu8_epi16(_mm256_extracti128_si256(mult, 1)));
+    __m256i sign_lo = _mm256_cvtepi8_epi16(_mm256_castsi256_si128(sign));
+    __m256i sign_hi = _mm256_cvtepi8_epi16(_mm256_extracti128_si256(sign, 1));
+    lo = _mm256_sub_epi16(_mm256_xor_si256(lo, sign_lo), sign_lo);
+    hi = _mm256_sub_epi16(_mm256_xor_si256(hi, sign_hi), sign_hi);
+
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(samples + i), lo);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(samples + i + 16), hi);
+  }
+
+  DecodeAlawScalar(alaw_samples + i, len - i, samples + i);
+}
+#endif
+
+typedef void (*DecodeAlawKernel)(const int8_t *, size_t, int16_t *);
+
+static DecodeAlawKernel SelectAlawKernel() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return DecodeAlawAVX2;
+  }
+  if (__builtin_cpu_supports("ssse3")) {
+    return DecodeAlawSSSE3;
+  }
+#endif
+  return DecodeAlawScalar;
+}
+
+void DecodeAlaw(const int8_t *alaw_samples, size_t len, int16_t *samples) {
+  // The kernel is selected once, on the first call
+  static const DecodeAlawKernel kernel = SelectAlawKernel();
+  kernel(alaw_samples, len, samples);
+}
@@ -24,6 +24,7 @@ void Argparser::Parse(int argc, char *argv[]) {
         ("help,h", "produce help message")
         ("verbose,v", "enable verbose output")
         ("debug,d", "enable debug mode, saves rtp streams to the disk\n")
+        ("early,e", "analyze calls while running and hang up as soon as a modem or fax is detected")
         ("username,u", po::value<std::string>(&username), "set SIP Provider Username")
         ("password,p", po::value<std::string>(&password), "set SIP Provider Password")
         ("server,s", po::value<std::string>(&server), "set URI of SIP Server")
@@ -31,7 +32,16 @@ void Argparser::Parse(int argc, char *argv[]) {
         ("file,f", po::value<std::string>(&path_to_numbers), "specfiy a file with numbers to wardial")
         ("threads,t", po::value<int>(&threads)->default_value(1),
                                           "set how many wardialing calls should be done parallel\n")
-        ("analyse,a", po::value<std::string>(&path_to_audio), "analyze a file");
+        ("analyse,a", po::value<std::string>(&path_to_audio),
+                                          "analyze a file, a directory, a wildcard pattern or a list of files")
+        ("output,o", po::value<std::string>(&path_to_output),
+                                          "write analysis results to a JSONL file instead of the database")
+        ("engine", po::value<std::string>(&engine)->default_value("fft"),
+                                          "set the detector engine used for analyzing: fft or goertzel")
+        ("rtp", po::value<std::string>(&rtp)->default_value("epoll"),
+                                          "set how RTP streams are received: ortp or epoll")
+        ("durability", po::value<std::string>(&durability)->default_value("fast"),
+                                          "set the database durability profile: fast, safe or compat");
 
     // store values in variable map vm
     po::store(po::parse_command_line(argc, argv, desc), vm);
@@ -46,6 +56,15 @@ void Argparser::Parse(int argc, char *argv[]) {
       Logger::GetLogger()->Log(warn_illegal, LOG_LVL_WARN);
       this->debug = true;
     }
+    DBProfile profile;
+    if ((engine != "fft" && engine != "goertzel") || (rtp != "ortp" && rtp != "epoll") ||
+        !DBProfile::FromName(durability, &profile)) {
+      Argparser::PrintUsage(0);
+      throw "Wrong Usage!";
+    }
+    if (vm.count("early")) {
+      this->early_hangup = true;
+    }
     if (vm.count("help")) {
       Argparser::PrintUsage(1);
     } else if (!path_to_audio.empty()) {
@@ -112,7 +131,7 @@ void Argparser::ParseNumbers() {
         if (pos_h != std::string::npos) {
           ParseNumberRange(number.substr(pos_o, pos-pos_o), pos_h);
         } else {
-         numbers.push_back(number.substr(pos_o, pos-pos_o));
+         numbers.AddNumber(number.substr(pos_o, pos-pos_o));
         }
         pos_o = pos+1;
         pos = number.find(',', pos_o);
@@ -121,32 +140,27 @@ void Argparser::ParseNumbers() {
       if (pos_h != std::string::npos) {
         ParseNumberRange(number.substr(pos_o), pos_h);
       } else {
-        numbers.push_back(number.substr(pos_o));
+        numbers.AddNumber(number.substr(pos_o));
       }
     } else {
       pos_h = number.find('-');
       if (pos_h != std::string::npos) {
           ParseNumberRange(number, pos_h);
         } else {
-         numbers.push_back(number);
+         numbers.AddNumber(number);
         }
       }
   }
 }
 
 void Argparser::ParseNumberRange(std::string number_range, size_t pos) {
-  // store number ranges defined with '-' in the numbers vector
+  // store number ranges defined with '-' in the numbers list, they are
+  // formatted with leading zeros to the width of the first number on demand
   int64_t number1 = std::stoll(number_range.substr(0, pos));
   int64_t number2 = std::stoll(number_range.substr(pos+1));
   int64_t max = number1 > number2 ? number1:number2;
   int64_t min = number1 < number2 ? number1:number2;
-  for (int64_t i = min; i <= max; i++) {
-    std::string num = std::to_string(i);
-    while (num.length() < number_range.substr(0, pos).length()) {
-      num.insert(0, "0");
-    }
-    numbers.push_back(num);
-  }
+  numbers.AddRange(min, max, pos);
 }
 
 void Argparser::PrintUsage(bool help) {
@@ -155,7 +169,7 @@ void Argparser::PrintUsage(bool help) {
     std::cout << "Wardialing:\n"
       << "swd -u USERNAME -p PASSWORD -s URI -n NUMBER" << "\n\n";
     std::cout << "Analyse an audio file to determine if the sounds were produced by a modem:\n"
-     << "swd -a PATHTOFILE" << "\n\n";
+     << "swd -a PATHTOFILE|DIRECTORY|PATTERN|FILELIST [-o RESULTS.jsonl]" << "\n\n";
     if (help) {
           std::cout << desc << "\n";
     } else {
@@ -175,6 +189,18 @@ std::string Argparser::GetPathToAudio() {
   return this->path_to_audio;
 }
 
+std::string Argparser::GetPathToOutput() {
+  return this->path_to_output;
+}
+
+int Argparser::GetAnalysisThreads() {
+  if (!vm["threads"].defaulted()) {
+    return this->threads > 0 ? this->threads : 1;
+  }
+  int cores = static_cast<int>(std::thread::hardware_concurrency());
+  return cores > 0 ? cores : 1;
+}
+
 std::string Argparser::GetUsername() {
   return this->username;
 }
@@ -191,10 +217,28 @@ std::string Argparser::GetServer() {
   return this->server;
 }
 
-std::vector<std::string> Argparser::GetNumbers() {
+const NumberList& Argparser::GetNumbers() {
   return this->numbers;
 }
 
 bool Argparser::GetDebugStatus() {
   return this->debug;
 }
+
+bool Argparser::GetEarlyHangup() {
+  return this->early_hangup;
+}
+
+DetectorEngine Argparser::GetEngine() {
+  return this->engine == "goertzel" ? DetectorEngine::GOERTZEL : DetectorEngine::FFT;
+}
+
+bool Argparser::GetRtpEngine() {
+  return this->rtp == "epoll";
+}
+
+DBProfile Argparser::GetDBProfile() {
+  DBProfile profile;
+  DBProfile::FromName(this->durability, &profile);
+  return profile;
+}
@@ -1,166 +1,264 @@
 // Copyright 2020 Barger M., Knoll M., Kofler L.
 #include "audio_analyzer.hpp"
 
-AudioAnalyzer::AudioAnalyzer() {
-    this->max_frq = 0;
-    this->max_peak = 0;
+// All frequencies the modem and fax classifiers look at
+static const int goertzel_freqs[GOERTZEL_TONES] = {600, 1100, 1625, 1665, 1800, 1825, 1855, 2100, 2220, 2230,
+  2250, 3000};
+
+bool CompareByAmplitude(const Measurement &a, const Measurement &b) {
+  return (a.power > b.power);
 }
 
-void  AudioAnalyzer::GetSpectraFromFile(Wav *wav) {
-  this->wav = wav;
+AudioAnalyzer::AudioAnalyzer(DetectorEngine engine) : spectra(spectrum_axis.frequency, NFREQS) {
+  this->wav = nullptr;
+  this->max_frq = 0;
+  this->max_peak = 0;
+  this->verdict = false;
+  this->frame_len = 0;
+  this->engine = engine;
+  this->peak_count = PEAK_COUNT;
+  this->retain_spectra = true;
+
+  for (int i = 0; i < GOERTZEL_TONES; i++) {
+    goertzel_coeffs[i] = 2 * cos(2 * M_PI * goertzel_freqs[i] / SAMPLE_RATE);
+  }
 
-  kiss_fftr_cfg cfg = NULL;
-  kiss_fft_scalar *tbuf;
-  kiss_fft_cpx *fbuf;
+  tbuf = static_cast<kiss_fft_scalar*>(malloc(sizeof(kiss_fft_scalar)*(NFFT + 2)));
 
-  float *mag2buf;
-  uint nfreqs;
-  int avfctr = 0;
-  int nrows = 0;
-  int navg = 1;
+  fcnt.fill(0.f);
+}
 
-  cfg = kiss_fftr_alloc(NFFT, 0, 0, 0);
-  tbuf = static_cast<kiss_fft_scalar*>(malloc(sizeof(kiss_fft_scalar)*(NFFT + 2)));
-  fbuf = static_cast<kiss_fft_cpx*>(malloc(sizeof(kiss_fft_cpx)*(NFFT + 2)));
-  mag2buf = static_cast<float*>(malloc(sizeof(float)*(NFFT + 2)));
-
-  uint idx = 0;
-  uint samples_len = wav->GetSamples().size();
-
-
-  while (idx < samples_len) {
-  	/*
-        Prepare buffer for fft. Since fft can only calculate frequeny
-        bins with a size of the power of two nfft has to be the next power
-        of two of the sample rate. Since nfft is bigger than sample rate
-        we have to fill the rest of the buffer with zeros.
-    */
-    for (uint i = 0; i < NFFT; i++) {
-      if (idx + i >= samples_len) {
-        tbuf[i] = 0;
-      } else {
-        tbuf[i] = wav->GetSamples().at(idx + i);
-      }
-    }
+AudioAnalyzer::~AudioAnalyzer() {
+  free(tbuf);
+}
 
-    // Get frequency spectrum from a frequency bin
-    kiss_fftr(cfg, tbuf, fbuf);
-    // Calculate nyquist frequency = max frequency NFFT / 2
-    nfreqs = NFFT / 2 - 1;
+void  AudioAnalyzer::GetSpectraFromFile(Wav *wav) {
+  this->wav = wav;
+
+  // Analyze the file frame by frame, the incomplete last frame is analyzed
+  // by Finish()
+  SampleView samples = wav->GetSamples();
+  Feed(samples.data(), samples.size());
+}
 
-    // Fill buffer with frequencys
-    for (uint i = 0; i < nfreqs; ++i) {
-      mag2buf[i] += fbuf[i].r * fbuf[i].r + fbuf[i].i * fbuf[i].i;
+void AudioAnalyzer::AnalyzeFrame() {
+  if (engine == DetectorEngine::GOERTZEL) {
+    AnalyzeFrameGoertzel();
+    if (!verdict) {
+      verdict = IsModem() || IsFax();
     }
+    return;
+  }
 
-    if (++avfctr == navg) {
-      float eps = 1;
-      avfctr = 0;
-      nrows++;
-      std::vector<Measurement> set;
-
-      // There highest nfreqs can only be = nfreqs
-      for (uint i = 0; i < nfreqs; ++i) {
-        float pwr = 10 * log10(mag2buf[i] / navg + eps);
-        Measurement measurement;
-
-        // amplitude of frequency
-        measurement.power = pwr;
-        // frequency
-        measurement.frequency = static_cast<float>(i) *
-          (static_cast<float>(wav->GetSampleRate()) / 2) / static_cast<float>(nfreqs);
-        set.push_back(measurement);
-      }
+  // Borrow the plan and buffers of the current thread
+  FFTScratch *scratch = FFTArena::GetArena()->GetScratch(NFFT);
+  kiss_fft_cpx *fbuf = scratch->fbuf.data();
+  float *mag2buf = scratch->mag2buf.data();
+
+  // Get frequency spectrum from a frequency bin
+  kiss_fftr(scratch->cfg, tbuf, fbuf);
+  // Fill buffer with the power of each frequency in dB
+  float eps = 1;
+  for (uint i = 0; i < NFREQS; ++i) {
+    mag2buf[i] = 10 * log10(fbuf[i].r * fbuf[i].r + fbuf[i].i * fbuf[i].i + eps);
+  }
 
-      // push set of freqeuncy and amplitude. freuqency is the key (first element in vector)
-      spectra.push_back(set);
-      memset(mag2buf, 0, sizeof(mag2buf[0]) * nfreqs);
-    }
+  SelectPeaks(mag2buf);
+  CalculateSignificantFrequencies(peaks);
+  CalculatePeakFrequency(peaks);
 
-      // Go to next freqeuency frame
-    idx += NFFT;
+  if (retain_spectra) {
+    spectra.AddFrame(mag2buf);
   }
 
-  free(cfg);
-  free(tbuf);
-  free(fbuf);
-  free(mag2buf);
+  if (!verdict) {
+    verdict = IsModem() || IsFax();
+  }
 }
 
-bool CompareByAmplitude(const Measurement &a, const Measurement &b) {
-  return (a.power > b.power);
-}
+void AudioAnalyzer::AnalyzeFrameGoertzel() {
+  const uint block_len = NFFT / GOERTZEL_BLOCKS;
+  float energy[GOERTZEL_TONES] = {0};
+  bool detected[GOERTZEL_TONES] = {false};
+
+  for (uint b = 0; b < GOERTZEL_BLOCKS; b++) {
+    // Run all filters side by side over the block
+    const kiss_fft_scalar *block = tbuf + b * block_len;
+    float s1[GOERTZEL_TONES] = {0};
+    float s2[GOERTZEL_TONES] = {0};
+    double block_energy = 0;
+
+    for (uint i = 0; i < block_len; i++) {
+      float x = block[i];
+      block_energy += static_cast<double>(x) * x;
+      for (int t = 0; t < GOERTZEL_TONES; t++) {
+        float s0 = x + goertzel_coeffs[t] * s1[t] - s2[t];
+        s2[t] = s1[t];
+        s1[t] = s0;
+      }
+    }
+    if (block_energy == 0) {
+      continue;
+    }
 
-void AudioAnalyzer::CalculateSignificantFrequencies() {
-  std::vector<std::vector<Measurement>> pkz;
+    // Tones which hold enough of the energy of the block, strongest first
+    float tone_energy[GOERTZEL_TONES];
+    int tones[GOERTZEL_TONES];
+    int tone_count = 0;
+    for (int t = 0; t < GOERTZEL_TONES; t++) {
+      tone_energy[t] = s1[t] * s1[t] + s2[t] * s2[t] - goertzel_coeffs[t] * s1[t] * s2[t];
+      energy[t] += tone_energy[t];
+      if (tone_energy[t] / (block_len / 2.0 * block_energy) >= GOERTZEL_THRESHOLD) {
+        int i = tone_count++;
+        for (; i > 0 && tone_energy[tones[i - 1]] < tone_energy[t]; i--) {
+          tones[i] = tones[i - 1];
+        }
+        tones[i] = t;
+      }
+    }
 
-  for (std::vector<Measurement> measurements : spectra) {
-    std::sort(measurements.begin(), measurements.end(), CompareByAmplitude);
-    std::vector<Measurement> tmp;
+    // Each block stands in for its part of the peak_count peaks of the frame,
+    // every detected tone is one of them, see GOERTZEL_THRESHOLD
+    int slots = peak_count * (b + 1) / GOERTZEL_BLOCKS - peak_count * b / GOERTZEL_BLOCKS;
+    for (int i = 0; i < std::min(slots, tone_count); i++) {
+      fcnt[FrequencyBucket(goertzel_freqs[tones[i]])] += 0.1;
+      detected[tones[i]] = true;
+    }
+  }
 
-    for (uint i = 0; i < 10; i++) {
-        tmp.push_back(measurements.at(i));
+  peaks.clear();
+  for (int t = 0; t < GOERTZEL_TONES; t++) {
+    if (!detected[t]) {
+      continue;
     }
 
-    pkz.push_back(tmp);
+    // Scale the energy to the power of a single bin of a NFFT sized fft
+    Measurement measurement;
+    measurement.frequency = goertzel_freqs[t];
+    measurement.power = 10 * log10(energy[t] * GOERTZEL_BLOCKS + 1);
+    measurement.bin = -1;
+    peaks.push_back(measurement);
   }
 
-  for (int i = 0; i < 800; i++) {
-    fcnt.insert(std::pair<int, float>(i * 5, 0.f));
+  std::sort(peaks.begin(), peaks.end(), CompareByAmplitude);
+  if (peaks.size() > peak_count) {
+    peaks.resize(peak_count);
   }
+  CalculatePeakFrequency(peaks);
+}
+
+void AudioAnalyzer::Feed(const int8_t *alaw_samples, size_t len) {
+  // Decode in chunks, a RTP payload fits into a single chunk
+  int16_t samples[512];
+  size_t chunk_len = sizeof(samples) / sizeof(samples[0]);
+
+  for (size_t idx = 0; idx < len; idx += chunk_len) {
+    size_t n = std::min(chunk_len, len - idx);
+    DecodeAlaw(alaw_samples + idx, n, samples);
+    Feed(samples, n);
+  }
+}
 
-  for (std::vector<Measurement> measurments : pkz) {
-    for (Measurement measurment : measurments) {
-      int fdx = static_cast<int>(std::round(measurment.frequency / 5.0) * 5.0);
+void AudioAnalyzer::Feed(const int16_t *samples, size_t len) {
+  for (size_t i = 0; i < len; i++) {
+    tbuf[frame_len++] = samples[i];
+    if (frame_len == NFFT) {
+      AnalyzeFrame();
+      frame_len = 0;
+    }
+  }
+}
 
-      std::map<int, float>::iterator fcnt_i = fcnt.find(fdx);
-      fcnt_i->second += 0.1;
+void AudioAnalyzer::Finish() {
+  // Fill the rest of the last frame with zeros, the same way as it is done
+  // when a whole file is analyzed
+  if (frame_len > 0) {
+    for (uint i = frame_len; i < NFFT; i++) {
+      tbuf[i] = 0;
     }
+    AnalyzeFrame();
+    frame_len = 0;
+  }
+
+  if (max_frq != 0 && max_peak != 0) {
+    Logger::GetLogger()->Log("Peak frequency in file " + std::to_string(max_frq)
+    + " with peak " + std::to_string(max_peak), LOG_LVL_INFO);
   }
 }
 
-void AudioAnalyzer::CalculatePeakFrequency() {
-  std::vector<std::vector<Measurement>> sorted_freqs;
+bool AudioAnalyzer::HasVerdict() {
+  return verdict;
+}
 
-  for (std::vector<Measurement> measurements : spectra) {
-    std::sort(measurements.begin(), measurements.end(), CompareByAmplitude);
-    std::vector<Measurement> tmp;
+void AudioAnalyzer::SetPeakCount(uint peak_count) {
+  this->peak_count = peak_count;
+}
 
-    for (uint i = 0; i < 10; i++) {
-        tmp.push_back(measurements.at(i));
-    }
+void AudioAnalyzer::SetRetainSpectra(bool retain_spectra) {
+  this->retain_spectra = retain_spectra;
+}
+
+const Spectrogram &AudioAnalyzer::GetSpectra() {
+  return spectra;
+}
 
-    sorted_freqs.push_back(tmp);
+void AudioAnalyzer::SelectPeaks(const float *power) {
+  // Keep the peaks sorted by power and only insert bins which are higher
+  // than the lowest peak so far
+  peaks.clear();
+  if (peak_count == 0) {
+    return;
   }
 
-  for (std::vector<Measurement> measurements : sorted_freqs) {
-    for (Measurement measurement : measurements) {
-      int f = std::round(measurement.frequency);
-      int p = std::round(measurement.power);
+  for (int i = 0; i < NFREQS; i++) {
+    if (peaks.size() == peak_count && power[i] <= peaks.back().power) {
+      continue;
+    }
 
-      if (f == 0) continue;
-      if (p < 1) continue;
+    Measurement measurement;
+    measurement.frequency = spectrum_axis.frequency[i];
+    measurement.power = power[i];
+    measurement.bin = i;
 
-      if (measurement.power > max_peak) {
-        max_frq = measurement.frequency;
-        max_peak = measurement.power;
-      }
+    if (peaks.size() == peak_count) {
+      peaks.pop_back();
     }
+    peaks.insert(std::upper_bound(peaks.begin(), peaks.end(), measurement, CompareByAmplitude), measurement);
   }
+}
 
-  if (max_frq != 0 && max_peak != 0) {
-    Logger::GetLogger()->Log("Peak frequency in file " + std::to_string(max_frq)
-    + " with peak " + std::to_string(max_peak), LOG_LVL_INFO);
+void AudioAnalyzer::CalculateSignificantFrequencies(const std::vector<Measurement> &peaks) {
+  for (const Measurement &measurement : peaks) {
+    fcnt[spectrum_axis.bucket[measurement.bin]] += 0.1;
+  }
+}
+
+void AudioAnalyzer::CalculatePeakFrequency(const std::vector<Measurement> &peaks) {
+  for (const Measurement &measurement : peaks) {
+    int f = std::round(measurement.frequency);
+    int p = std::round(measurement.power);
+
+    if (f == 0) continue;
+    if (p < 1) continue;
+
+    if (measurement.power > max_peak) {
+      max_frq = measurement.frequency;
+      max_peak = measurement.power;
+    }
   }
 }
 
 bool AudioAnalyzer::IsModem() {
-  if ( (fcnt.find(2100)->second > 1.0 || fcnt.find(2230)->second > 1.0 )
-      && fcnt.find(2250)->second > 0.5) {
+  constexpr int f2100 = FrequencyBucket(2100);
+  constexpr int f2230 = FrequencyBucket(2230);
+  constexpr int f2250 = FrequencyBucket(2250);
+
+  if ( (fcnt[f2100] > 1.0 || fcnt[f2230] > 1.0 )
+      && fcnt[f2250] > 0.5) {
     return true;
-  } else if (fcnt.find(2100)->second > 1.0 && (max_frq > 2245.0 && max_frq < 2255.0)) {
+  } else if (fcnt[f2100] > 1.0 && (max_frq > 2245.0 && max_frq < 2255.0)) {
     return true;
-  } else if (fcnt.find(2100)->second> 1.0 && (max_frq > 2995.0 && max_frq < 3005.0)) {
+  } else if (fcnt[f2100] > 1.0 && (max_frq > 2995.0 && max_frq < 3005.0)) {
     return true;
   }
 
@@ -168,12 +266,13 @@ bool AudioAnalyzer::IsModem() {
 }
 
 bool AudioAnalyzer::IsFax() {
-  int fax_freqs[] = {1625, 1665, 1825, 600, 1855,
-    1100, 2250, 2230, 2220, 1800};
+  constexpr int fax_buckets[] = {FrequencyBucket(1625), FrequencyBucket(1665), FrequencyBucket(1825),
+    FrequencyBucket(600), FrequencyBucket(1855), FrequencyBucket(1100), FrequencyBucket(2250),
+    FrequencyBucket(2230), FrequencyBucket(2220), FrequencyBucket(1800)};
   double fax_sum = 0.0;
 
-  for (int fax_freq : fax_freqs) {
-    fax_sum += fcnt.find(fax_freq)->second;
+  for (int fax_bucket : fax_buckets) {
+    fax_sum += fcnt[fax_bucket];
   }
 
   if (fax_sum > 2.0) {
@@ -184,9 +283,9 @@ bool AudioAnalyzer::IsFax() {
 }
 
 void AudioAnalyzer::PrintSignificantFrequencies(float bottom_limit) {
-  for (std::pair<int, float> pair : fcnt) {
-    if (pair.second > bottom_limit) {
-      std::cout << pair.first << " : " << pair.second << std::endl;
+  for (int i = 0; i < FCNT_BUCKETS; i++) {
+    if (fcnt[i] > bottom_limit) {
+      std::cout << i * BUCKET_WIDTH << " : " << fcnt[i] << std::endl;
     }
   }
 }
@@ -223,14 +322,14 @@ std::string AudioAnalyzer::GetReadableLineType() {
   return readable_line_type;
 }
 
-void AudioAnalyzer::Analyze(Wav *wav) {
-  if (wav->GetSampleRate() == 8000) {
-    GetSpectraFromFile(wav);
-    CalculateSignificantFrequencies();
-    CalculatePeakFrequency();
-  } else {
+bool AudioAnalyzer::Analyze(Wav *wav) {
+  if (wav->GetSampleRate() != SAMPLE_RATE) {
     Logger::GetLogger()->Log("Can't analyze audio because sample rate is not 8000 samples per second"  , LOG_LVL_ERROR);
+    return false;
   }
+  GetSpectraFromFile(wav);
+  Finish();
+  return true;
 }
 
 
@@ -0,0 +1,232 @@
+// Copyright 2020 Barger M., Knoll M., Kofler L.
+
+#include "batch_analyzer.hpp"
+
+#include <glob.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono> // NOLINT
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <mutex> // NOLINT
+#include <sstream>
+#include <thread> // NOLINT
+
+#include "argparse.hpp"
+#include "db_writer.hpp"
+#include "fft_plan_cache.hpp"
+#include "log.hpp"
+#include "wav.hpp"
+
+namespace fs = std::filesystem;
+
+static bool HasWavExtension(const fs::path &path) {
+  std::string ext = path.extension().string();
+  std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+  return ext == ".wav";
+}
+
+// Returns true if a regular file is a list of recordings. Lists are text
+// files, a file with a wav extension, a RIFF header or binary content is
+// taken as recording.
+static bool IsListFile(const std::string &path) {
+  if (HasWavExtension(path)) {
+    return false;
+  }
+
+  char head[512];
+  std::ifstream file(path, std::ios::binary);
+  file.read(head, sizeof(head));
+  std::string content(head, file.gcount());
+  return content.compare(0, 4, "RIFF") != 0 && content.find('\0') == std::string::npos;
+}
+
+bool IsSingleRecording(const std::string &path) {
+  std::error_code ec;
+  if (fs::is_directory(path, ec) || path.find_first_of("*?[") != std::string::npos) {
+    return false;
+  }
+  return !fs::is_regular_file(path, ec) || !IsListFile(path);
+}
+
+std::vector<std::string> CollectAudioFiles(const std::string &path) {
+  std::vector<std::string> files;
+  std::error_code ec;
+
+  if (fs::is_directory(path, ec)) {
+    for (auto it = fs::recursive_directory_iterator(path, fs::directory_options::skip_permission_denied, ec);
+         it != fs::recursive_directory_iterator(); it.increment(ec)) {
+      if (ec) {
+        break;
+      }
+      if (it->is_regular_file(ec) && HasWavExtension(it->path())) {
+        files.push_back(it->path().string());
+      }
+    }
+  } else if (path.find_first_of("*?[") != std::string::npos) {
+    glob_t matches;
+    if (glob(path.c_str(), 0, nullptr, &matches) == 0) {
+      for (size_t i = 0; i < matches.gl_pathc; i++) {
+        if (fs::is_regular_file(matches.gl_pathv[i], ec)) {
+          files.push_back(matches.gl_pathv[i]);
+        }
+      }
+    }
+    globfree(&matches);
+  } else if (IsSingleRecording(path)) {
+    // Errors are reported when the recording is read
+    files.push_back(path);
+  } else {
+    // A list of recordings, one path per line
+    Logger::GetLogger()->Log("Reading the recordings listed in " + path, LOG_LVL_INFO);
+    std::ifstream list(path);
+    std::string line;
+    while (std::getline(list, line)) {
+      line.erase(line.find_last_not_of(" \t\r") + 1);
+      line.erase(0, line.find_first_not_of(" \t"));
+      if (!line.empty()) {
+        files.push_back(line);
+      }
+    }
+  }
+
+  if (ec) {
+    Logger::GetLogger()->Log("Failed to list " + path + ": " + ec.message(), LOG_LVL_ERROR);
+  }
+
+  std::sort(files.begin(), files.end());
+  return files;
+}
+
+BatchResult AnalyzeAudioFile(const std::string &file, DetectorEngine engine) {
+  BatchResult result;
+  result.file = file;
+  result.status = "Analyzing failed";
+  result.line_type = -1;
+  result.duration = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  Wav wav;
+  AudioAnalyzer audio_analyzer(engine);
+  audio_analyzer.SetRetainSpectra(false);
+  // Recordings with another sample rate are read, but not analyzed
+  if (wav.Read(file) && audio_analyzer.Analyze(&wav)) {
+    result.status = "Finished";
+    result.dev_type = audio_analyzer.GetReadableLineType();
+    result.line_type = audio_analyzer.GetLineType();
+    result.duration = wav.GetDuration();
+  }
+  result.analysis_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+  return result;
+}
+
+std::string EscapeJson(const std::string &str) {
+  std::string escaped;
+  escaped.reserve(str.size());
+  for (char c : str) {
+    switch (c) {
+      case '"': escaped += "\\\""; break;
+      case '\\': escaped += "\\\\"; break;
+      case '\n': escaped += "\\n"; break;
+      case '\r': escaped += "\\r"; break;
+      case '\t': escaped += "\\t"; break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          char buf[8];
+          snprintf(buf, sizeof(buf), "\\u%04x", c);
+          escaped += buf;
+        } else {
+          escaped += c;
+        }
+    }
+  }
+  return escaped;
+}
+
+// Formats a result as one line of JSON
+static std::string ResultToJson(const BatchResult &result) {
+  std::ostringstream line;
+  line << "{\"file\":\"" << EscapeJson(result.file) << "\""
+       << ",\"status\":\"" << result.status << "\""
+       << ",\"dev_type\":\"" << result.dev_type << "\""
+       << ",\"duration\":" << result.duration
+       << ",\"analysis_ms\":" << result.analysis_ms << "}";
+  return line.str();
+}
+
+int BatchAnalyzer() {
+  Argparser *args = Argparser::GetArgparser();
+  std::vector<std::string> files = CollectAudioFiles(args->GetPathToAudio());
+  if (files.empty()) {
+    Logger::GetLogger()->Log("No recordings found at " + args->GetPathToAudio(), LOG_LVL_ERROR);
+    return 1;
+  }
+
+  // Results are written either to a JSONL file or to the database, the
+  // result of a single recording without -o is only logged
+  std::string output = args->GetPathToOutput();
+  std::ofstream jsonl;
+  DBWriter *db = nullptr;
+  if (output.empty() && IsSingleRecording(args->GetPathToAudio())) {
+    Logger::GetLogger()->Log("Analyzing a single recording, the result is not stored", LOG_LVL_INFO);
+  } else if (!output.empty()) {
+    jsonl.open(output, std::ofstream::app);
+    if (!jsonl.is_open()) {
+      Logger::GetLogger()->Log("Failed to open output file " + output, LOG_LVL_ERROR);
+      return 1;
+    }
+  } else {
+    db = new DBWriter("wardialing.db", args->GetDBProfile());
+    if (!db->IsOpen()) {
+      Logger::GetLogger()->Log("Can't use the database, no recordings are analyzed", LOG_LVL_ERROR);
+      delete db;
+      return 1;
+    }
+  }
+  std::mutex output_mutex;
+
+  int workers = std::min(args->GetAnalysisThreads(), static_cast<int>(files.size()));
+  Logger::GetLogger()->Log("Analyzing " + std::to_string(files.size()) + " recordings with " +
+    std::to_string(workers) + " threads", LOG_LVL_INFO);
+
+  std::atomic<size_t> next_file = 0;
+  auto worker = [&](int thread_id) {
+    for (size_t i = next_file++; i < files.size(); i = next_file++) {
+      BatchResult result = AnalyzeAudioFile(files[i], args->GetEngine());
+      if (result.status == "Finished") {
+        Logger::GetLogger()->Log(result.dev_type + " detected in file " + result.file, LOG_LVL_STATUS, thread_id);
+      } else {
+        Logger::GetLogger()->Log("Analyzing failed for file " + result.file, LOG_LVL_STATUS, thread_id);
+      }
+      Logger::GetLogger()->Log("Analyzed " + result.file + " in " + std::to_string(result.analysis_ms) + " ms",
+        LOG_LVL_INFO, thread_id);
+
+      if (db != nullptr) {
+        db->WriteRecording(result.file, result.line_type >= 0 ? STATUS_FINISHED : STATUS_ANALYZING_FAILED,
+          result.line_type, static_cast<int>(result.duration), result.analysis_ms);
+      } else if (jsonl.is_open()) {
+        std::lock_guard<std::mutex> lock(output_mutex);
+        jsonl << ResultToJson(result) << "\n";
+      }
+    }
+  };
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (int i = 1; i <= workers; i++) {
+    threads.push_back(std::thread(worker, workers > 1 ? i : 0));
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  Logger::GetLogger()->Log("Analyzed " + std::to_string(files.size()) + " recordings in " +
+    std::to_string(seconds) + " seconds", LOG_LVL_INFO);
+  LogPlanCacheStats();
+
+  delete db;
+  return 0;
+}
@@ -0,0 +1,150 @@
+// Copyright 2020 Barger M., Knoll M., Kofler L.
+
+#include "call_manager.hpp"
+
+#include <chrono> // NOLINT
+
+CallManager::CallManager(std::string username, std::string password, std::string uri, int port)
+    : timers(TIMER_TICK_MS) {
+  this->context = nullptr;
+
+  // Initialize context
+  if ( (context = eXosip_malloc()) == nullptr ) {
+    Logger::GetLogger()->Log("eXosip_malloc() failed.", LOG_LVL_FATAL);
+    throw "Fatal error in CallManager()";
+  }
+
+  if ( eXosip_init(context) != 0 ) {
+    Logger::GetLogger()->Log("eXosip_init() failed", LOG_LVL_FATAL);
+    throw "Fatal error in CallManager()";
+  }
+
+  // Set data
+  this->username = username;
+  this->server_uri = uri;
+
+  // Set User Agent
+  eXosip_set_user_agent(this->context, "swd");
+
+  // Start listening socket for SIP
+  if ( eXosip_listen_addr(context, IPPROTO_UDP, nullptr, port, AF_INET, 0) != 0 ) {
+    Logger::GetLogger()->Log("Failed to open UDP socket", LOG_LVL_ERROR);
+    eXosip_quit(context);
+    throw "Fatal error in CallManager()";
+  }
+
+  registration = new RegistrationManager(context, username, password, uri);
+  running = true;
+  event_thread = std::thread(&CallManager::EventLoop, this);
+}
+
+CallManager::~CallManager() {
+  // Deregister while the event thread still delivers the answer
+  registration->Unregister();
+
+  running = false;
+  if (event_thread.joinable()) {
+    event_thread.join();
+  }
+  delete registration;
+  eXosip_quit(context);
+}
+
+bool CallManager::Register() {
+  return registration->Register();
+}
+
+int CallManager::SendInvite(osip_message_t *invite_msg, CallHandler *handler) {
+  // The handler is added before the event thread can dispatch the first
+  // event of the call, as it needs calls_mutex for dispatching
+  std::lock_guard<std::mutex> lock(calls_mutex);
+  eXosip_lock(context);
+  int cid = eXosip_call_send_initial_invite(context, invite_msg);
+  eXosip_unlock(context);
+
+  if (cid > 0) {
+    calls[cid] = handler;
+  }
+  return cid;
+}
+
+void CallManager::RemoveCall(int cid) {
+  std::lock_guard<std::mutex> lock(calls_mutex);
+  calls.erase(cid);
+}
+
+TimingWheel::TimerId CallManager::StartTimer(int cid, int delay_ms) {
+  return timers.Schedule(delay_ms, [this, cid](TimingWheel::TimerId id) { DispatchTimeout(cid, id); });
+}
+
+void CallManager::CancelTimer(TimingWheel::TimerId id) {
+  timers.Cancel(id);
+}
+
+eXosip_t *CallManager::GetContext() {
+  return context;
+}
+
+std::string CallManager::GetServerUri() {
+  return server_uri;
+}
+
+std::string CallManager::GetUsername() {
+  return username;
+}
+
+bool CallManager::IsRegistered() {
+  return registration->IsRegistered();
+}
+
+bool CallManager::WaitForRegistration(const std::atomic<bool> &cancel) {
+  return registration->WaitForRegistration(cancel);
+}
+
+void CallManager::EventLoop() {
+  // Blocks in eXosip_event_wait() until an event arrives or the next timer
+  // tick is due
+  while (running) {
+    eXosip_event_t *event = eXosip_event_wait(context, 0, TIMER_TICK_MS);
+
+    // Process retransmissions, authentication and refreshes
+    eXosip_lock(context);
+    eXosip_automatic_action(context);
+    eXosip_unlock(context);
+
+    if (event != nullptr) {
+      Dispatch(event);
+    }
+    timers.Advance(std::chrono::steady_clock::now());
+  }
+}
+
+void CallManager::Dispatch(eXosip_event_t *event) {
+  if (event->type == EXOSIP_REGISTRATION_SUCCESS || event->type == EXOSIP_REGISTRATION_FAILURE) {
+    registration->OnEvent(event);
+    eXosip_event_free(event);
+    return;
+  }
+
+  CallHandler *handler = FindCall(event->cid);
+  if (handler != nullptr) {
+    handler->OnEvent(event);
+  }
+  eXosip_event_free(event);
+}
+
+void CallManager::DispatchTimeout(int cid, TimingWheel::TimerId id) {
+  CallHandler *handler = FindCall(cid);
+  if (handler != nullptr) {
+    handler->OnTimeout(id);
+  }
+}
+
+CallHandler *CallManager::FindCall(int cid) {
+  // Only handlers on the event thread remove calls, so the handler stays
+  // valid after the mutex is released. It is not held while the handler
+  // runs, so the handler may end its call and start new ones.
+  std::lock_guard<std::mutex> lock(calls_mutex);
+  auto call = calls.find(cid);
+  return call != calls.end() ? call->second : nullptr;
+}
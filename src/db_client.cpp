@@ -2,225 +2,456 @@
 
 #include "db_client.hpp"
 
-DBClient::DBClient(std::string path) {
+#include <strings.h>
+#include <ctime>
+#include <utility>
+
+bool SplitNumber(const std::string &number, int64_t *value, int *leading_zeros) {
+  size_t begin = number.size() > 0 && number[0] == '+' ? 1 : 0;
+  if (begin == number.size()) {
+    return false;
+  }
+  for (size_t i = begin; i < number.size(); i++) {
+    if (number[i] < '0' || number[i] > '9') {
+      return false;
+    }
+  }
+
+  // At least one digit is kept as value, "0" is 0 without leading zeros
+  size_t first = number.find_first_not_of('0', begin);
+  if (first == std::string::npos) {
+    first = number.size() - 1;
+  }
+  if (number.size() - first > 18 || first - begin > 18) {
+    return false;
+  }
+  *value = std::stoll(number.substr(first));
+  *leading_zeros = static_cast<int>(first - begin);
+  return true;
+}
+
+CallRecord::CallRecord(int64_t seq, std::string number) : seq(seq), number(std::move(number)) {
+  start_time = time(nullptr);
+}
+
+bool DBProfile::FromName(const std::string &name, DBProfile *profile) {
+  *profile = DBProfile();
+  if (name == "fast") {
+    return true;
+  }
+  if (name == "safe") {
+    profile->synchronous = "FULL";
+    profile->mmap_size = 0;
+    profile->cache_size = -2000;
+    return true;
+  }
+  if (name == "compat") {
+    profile->journal_mode = "DELETE";
+    profile->synchronous = "FULL";
+    profile->mmap_size = 0;
+    profile->cache_size = -2000;
+    return true;
+  }
+  return false;
+}
+
+DBClient::DBClient(std::string path, const DBProfile &profile) {
   this->db = nullptr;
   this->path = path;
-  sqlite3_stmt *stmt = nullptr;
 
   int ret = sqlite3_open(this->path.c_str(), &db);
   if ( ret != SQLITE_OK ) {
     Logger::GetLogger()->Log("Failed to open db file", LOG_LVL_ERROR);
     return;
   }
-
-  // Create table if it does not exist
-  std::string cmd =
-    "CREATE TABLE IF NOT EXISTS calls("
-    "  id text primary key not null,"
-    "  number text not null,"
-    "  start_time text not null,"
-    "  duration integer,"
-    "  status text not null,"
-    "  dev_type text"
-    ");";
-
-  ret = sqlite3_prepare_v3(db, cmd.c_str(), -1, 0, &stmt, nullptr);
-  if (ret != SQLITE_OK) {
-    Logger::GetLogger()->Log("Failed to create sqlite create statement.", LOG_LVL_ERROR);
+  ApplyProfile(profile);
+  if (!CreateSchema()) {
+    Logger::GetLogger()->Log("Failed to create the database schema", LOG_LVL_ERROR);
     return;
   }
+  ready = true;
+}
 
-  ret = sqlite3_step(stmt);
+bool DBClient::IsOpen() {
+  return ready;
+}
 
-  if (ret != SQLITE_DONE) {
-    switch (ret) {
-      case SQLITE_BUSY:
-        Logger::GetLogger()->Log("Failed to create table: DB is locked.", LOG_LVL_ERROR);
-      break;
-      case SQLITE_ROW:
-        Logger::GetLogger()->Log("Failed to create table: Statement returned data when it should not.", LOG_LVL_ERROR);
-      break;
-      case SQLITE_MISUSE:
-        Logger::GetLogger()->Log("Failed to create table: Misuse detected.", LOG_LVL_ERROR);
-      break;
-      default:
-        Logger::GetLogger()->Log("Failed to create table: Error code " + std::to_string(ret), LOG_LVL_ERROR);
-    }
-    Logger::GetLogger()->Log(std::string(sqlite3_errmsg(db)), LOG_LVL_ERROR);
+std::string DBClient::GetPragma(const std::string &name) {
+  std::string value;
+  sqlite3_stmt *stmt = nullptr;
+  std::string cmd = "pragma " + name + ";";
+  if (sqlite3_prepare_v2(db, cmd.c_str(), -1, &stmt, nullptr) == SQLITE_OK && sqlite3_step(stmt) == SQLITE_ROW &&
+      sqlite3_column_text(stmt, 0) != nullptr) {
+    value = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0));
   }
-
   sqlite3_finalize(stmt);
+  return value;
 }
 
 DBClient::~DBClient() {
+  for (Statement &statement : statements) {
+    sqlite3_finalize(statement.stmt);
+  }
   if (db != nullptr) {
     sqlite3_close(db);
   }
 }
 
-bool DBClient::InsertData(std::string id, std::string number, std::string status, std::string dev_type) {
-  sqlite3_stmt *stmt = nullptr;
-  std::string cmd =
-    "insert into calls (id, number, status, dev_type, start_time) "
-    "values(@id, @number, @status, @dev_type, datetime());";
-
-  int ret = sqlite3_prepare_v3(db, cmd.c_str(), -1, 0, &stmt, nullptr);
-  if (ret != SQLITE_OK) {
-    Logger::GetLogger()->Log("Failed to create sqlite insert statement.", LOG_LVL_ERROR);
+bool DBClient::WriteRecord(const CallRecord &record) {
+  if (campaign == 0 && !StartCampaign()) {
+    return false;
+  }
+  Statement *statement = GetStatement(STMT_RECORD);
+  if (statement == nullptr) {
     return false;
   }
 
-  sqlite3_bind_text(stmt, sqlite3_bind_parameter_index(stmt, "@id"), id.c_str(), -1, 0);
-  sqlite3_bind_text(stmt, sqlite3_bind_parameter_index(stmt, "@number"), number.c_str(), -1, 0);
-  sqlite3_bind_text(stmt, sqlite3_bind_parameter_index(stmt, "@status"), status.c_str(), -1, 0);
-  sqlite3_bind_text(stmt, sqlite3_bind_parameter_index(stmt, "@dev_type"), dev_type.c_str(), -1, 0);
+  // Numbers which are not numeric are stored as text
+  int64_t value;
+  int leading_zeros;
+  if (SplitNumber(record.number, &value, &leading_zeros)) {
+    sqlite3_bind_int64(statement->stmt, statement->number, value);
+    sqlite3_bind_int(statement->stmt, statement->leading_zeros, leading_zeros);
+  } else {
+    sqlite3_bind_text(statement->stmt, statement->number, record.number.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_int(statement->stmt, statement->leading_zeros, 0);
+  }
 
-  ret = sqlite3_step(stmt);
-  if ( ret != SQLITE_DONE ) {
-    switch (ret) {
-      case SQLITE_BUSY:
-        Logger::GetLogger()->Log("Failed to insert entry into table: DB is locked.", LOG_LVL_ERROR);
-      break;
-      case SQLITE_ROW:
-        Logger::GetLogger()->Log("Failed to insert entry into table: Statement returned data when it should not.",
-          LOG_LVL_ERROR);
-      break;
-      case SQLITE_MISUSE:
-        Logger::GetLogger()->Log("Failed to insert entry into table: Misuse detected.", LOG_LVL_ERROR);
-      break;
-      default:
-        Logger::GetLogger()->Log("Failed to insert entry into table: Error code " + std::to_string(ret),
-          LOG_LVL_ERROR);
-    }
-    Logger::GetLogger()->Log(std::string(sqlite3_errmsg(db)), LOG_LVL_ERROR);
+  // Unbound parameters are null, a null duration or device type is unknown
+  sqlite3_bind_int64(statement->stmt, statement->campaign, campaign);
+  sqlite3_bind_int64(statement->stmt, statement->seq, record.seq);
+  sqlite3_bind_int64(statement->stmt, statement->start_time, record.start_time);
+  sqlite3_bind_int(statement->stmt, statement->status, record.status);
+  if (record.duration >= 0) {
+    sqlite3_bind_int(statement->stmt, statement->duration, record.duration);
+  }
+  if (record.dev_type >= 0) {
+    sqlite3_bind_int(statement->stmt, statement->dev_type, record.dev_type);
+  }
+  return Step(statement, "write record into table");
+}
+
+bool DBClient::WriteRecording(const std::string &path, CallStatus status, int dev_type, int duration,
+                              double analysis_ms) {
+  Statement *statement = GetStatement(STMT_RECORDING);
+  if (statement == nullptr) {
+    return false;
   }
 
-  sqlite3_finalize(stmt);
+  sqlite3_bind_text(statement->stmt, statement->path, path.c_str(), -1, SQLITE_STATIC);
+  sqlite3_bind_int(statement->stmt, statement->status, status);
+  sqlite3_bind_int(statement->stmt, statement->duration, duration);
+  sqlite3_bind_double(statement->stmt, statement->analysis_ms, analysis_ms);
+  if (dev_type >= 0) {
+    sqlite3_bind_int(statement->stmt, statement->dev_type, dev_type);
+  }
+  return Step(statement, "write recording into table");
+}
+
+bool DBClient::BeginTransaction() {
+  // Take the write lock at once, a deferred transaction would wait for it
+  // with every statement
+  return Execute("begin immediate transaction;");
+}
+
+bool DBClient::CommitTransaction() {
+  if (!Execute("commit transaction;")) {
+    return false;
+  }
+  campaign_uncommitted = false;
   return true;
 }
 
-bool DBClient::UpdateEntry(std::string id, std::string status, std::string dev_type) {
-  sqlite3_stmt *stmt = nullptr;
-  int ret = 0;
+bool DBClient::RollbackTransaction() {
+  if (campaign_uncommitted) {
+    campaign = 0;
+    campaign_uncommitted = false;
+  }
+  return Execute("rollback transaction;");
+}
 
-  if (status == "" && dev_type == "") {
+bool DBClient::CreateSchema() {
+  int64_t version = 0;
+  QueryInt("pragma user_version;", &version);
+  if (version == DB_SCHEMA_VERSION) {
     return true;
   }
+  if (version > DB_SCHEMA_VERSION) {
+    Logger::GetLogger()->Log("Database has the unknown schema version " + std::to_string(version), LOG_LVL_ERROR);
+    return false;
+  }
+
+  // Version 1 did not set user_version, its calls table has a text id
+  int64_t v1 = 0;
+  QueryInt("select count(*) from pragma_table_info('calls') where name = 'id' and lower(type) = 'text';", &v1);
+
   std::string cmd =
-    "update calls\n"
-    "set ";
+    "create table if not exists campaigns("
+    "  id integer primary key,"
+    "  start_time integer not null"
+    ");"
+    "create table if not exists statuses("
+    "  id integer primary key,"
+    "  name text not null unique"
+    ");"
+    "insert or ignore into statuses values"
+    "  (0, 'Ready'), (1, 'Calling'), (2, 'Call Finished'), (3, 'Call Failed'),"
+    "  (4, 'Analyzing'), (5, 'Finished'), (6, 'Analyzing failed'), (7, 'Unknown');"
+    "create table if not exists device_types("
+    "  id integer primary key,"
+    "  name text not null unique"
+    ");"
+    "insert or ignore into device_types values (0, 'Fax'), (1, 'Modem'), (2, 'Other');"
+    "create table if not exists calls("
+    "  id integer primary key,"
+    "  campaign integer not null references campaigns(id),"
+    "  seq integer not null,"
+    "  number integer not null,"
+    "  leading_zeros integer not null default 0,"
+    "  start_time integer not null,"
+    "  duration integer,"
+    "  status integer not null references statuses(id),"
+    "  dev_type integer references device_types(id),"
+    "  unique(campaign, seq)"
+    ");"
+    "create index if not exists calls_campaign_status on calls(campaign, status);"
+    "create index if not exists calls_number on calls(number);"
+    "create table if not exists recordings("
+    "  id integer primary key,"
+    "  path text not null unique,"
+    "  start_time integer not null,"
+    "  duration integer,"
+    "  status integer not null references statuses(id),"
+    "  dev_type integer references device_types(id),"
+    "  analysis_ms real"
+    ");"
+    "create view if not exists calls_readable as"
+    "  select calls.id, campaign, seq, substr('000000000000000000', 1, leading_zeros) || number as number,"
+    "    datetime(start_time, 'unixepoch') as start_time, duration,"
+    "    statuses.name as status, device_types.name as dev_type"
+    "  from calls join statuses on statuses.id = calls.status"
+    "    left join device_types on device_types.id = calls.dev_type;"
+    "create view if not exists recordings_readable as"
+    "  select recordings.id, path, datetime(start_time, 'unixepoch') as start_time, duration,"
+    "    statuses.name as status, device_types.name as dev_type, analysis_ms"
+    "  from recordings join statuses on statuses.id = recordings.status"
+    "    left join device_types on device_types.id = recordings.dev_type;"
+    "pragma user_version = " + std::to_string(DB_SCHEMA_VERSION) + ";";
 
-  if (status != "") {
-    cmd += "status = @status\n";
+  // The old table is only dropped if all entries have been copied. Version 2
+  // only lacks the analysis time of the recordings.
+  bool ok = Execute("begin transaction;");
+  ok = ok && (v1 == 0 || Execute("alter table calls rename to calls_v1;"));
+  ok = ok && (version != 2 || Execute("alter table recordings add column analysis_ms real;"
+    "drop view if exists recordings_readable;"));
+  ok = ok && Execute(cmd);
+  ok = ok && (v1 == 0 || MigrateV1());
+  if (!ok || !Execute("commit transaction;")) {
+    Execute("rollback transaction;");
+    return false;
   }
-  if (dev_type != "") {
-    cmd += status == "" ? "" : ",";
-    cmd += "dev_type = @dev_type\n";
+
+  if (v1 != 0) {
+    // Give the space of the old table back to the file system
+    Logger::GetLogger()->Log("Migrated database to schema version " + std::to_string(DB_SCHEMA_VERSION) +
+      ", compacting it", LOG_LVL_INFO);
+    Execute("vacuum;");
   }
-  cmd += "where id = @id;";
+  return true;
+}
 
-  ret = sqlite3_prepare_v3(db, cmd.c_str(), -1, 0, &stmt, nullptr);
-  if (ret != SQLITE_OK) {
-    switch (ret) {
-      case SQLITE_BUSY:
-        Logger::GetLogger()->Log("Failed to update entry in table: DB is locked.", LOG_LVL_ERROR);
-      break;
-      case SQLITE_ROW:
-        Logger::GetLogger()->Log("Failed to update entry in table: Statement returned data when it should not.",
-          LOG_LVL_ERROR);
-      break;
-      case SQLITE_MISUSE:
-        Logger::GetLogger()->Log("Failed to update entry in table: Misuse detected.", LOG_LVL_ERROR);
-      break;
-      default:
-        Logger::GetLogger()->Log("Failed to update entry in table: Error code " + std::to_string(ret),
-          LOG_LVL_ERROR);
-    }
-    Logger::GetLogger()->Log(std::string(sqlite3_errmsg(db)), LOG_LVL_ERROR);
+bool DBClient::MigrateV1() {
+  // Calls have the id number_counter, all other entries have been written by
+  // the batch analysis with the path as id. The calls of version 1 are put
+  // into one campaign and numbered by their rowid, the numbers are split like
+  // in SplitNumber(). Entries with a status which has no code are kept as
+  // STATUS_UNKNOWN.
+  int64_t unknown = 0;
+  QueryInt("select count(*) from calls_v1 left join statuses on lower(statuses.name) = lower(calls_v1.status)"
+    " where statuses.id is null;", &unknown);
+  if (unknown > 0) {
+    Logger::GetLogger()->Log("Migrating " + std::to_string(unknown) + " entries with an unknown status as '"
+      "Unknown'", LOG_LVL_WARN);
+  }
+
+  std::string cmd =
+    "insert into campaigns (start_time)"
+    "  select coalesce(cast(strftime('%s', min(start_time)) as integer), 0) from calls_v1"
+    "  where substr(id, 1, length(number) + 1) = number || '_' having count(*) > 0;"
+    "insert into calls (campaign, seq, number, leading_zeros, start_time, duration, status, dev_type)"
+    "  with v1 as ("
+    "    select rowid as seq, number, start_time, duration, status, dev_type,"
+    "      case when number like '+%' then substr(number, 2) else number end as digits"
+    "    from calls_v1 where substr(id, 1, length(number) + 1) = number || '_'"
+    "  ), split as ("
+    "    select *, digits <> '' and digits not glob '*[^0-9]*' and length(ltrim(digits, '0')) <= 18"
+    "      and length(digits) - max(length(ltrim(digits, '0')), 1) <= 18 as is_numeric from v1"
+    "  )"
+    "  select (select max(id) from campaigns), seq,"
+    "    case when is_numeric then cast(digits as integer) else number end,"
+    "    case when is_numeric then length(digits) - max(length(ltrim(digits, '0')), 1) else 0 end,"
+    "    coalesce(cast(strftime('%s', start_time) as integer), 0), duration,"
+    "    coalesce(statuses.id, " + std::to_string(STATUS_UNKNOWN) + "), device_types.id"
+    "  from split left join statuses on lower(statuses.name) = lower(split.status)"
+    "    left join device_types on device_types.name = split.dev_type;"
+    "insert into recordings (path, start_time, duration, status, dev_type)"
+    "  select calls_v1.id, coalesce(cast(strftime('%s', start_time) as integer), 0), duration,"
+    "    coalesce(statuses.id, " + std::to_string(STATUS_UNKNOWN) + "), device_types.id"
+    "  from calls_v1 left join statuses on lower(statuses.name) = lower(calls_v1.status)"
+    "    left join device_types on device_types.name = calls_v1.dev_type"
+    "  where substr(calls_v1.id, 1, length(number) + 1) <> number || '_';";
+  if (!Execute(cmd)) {
     return false;
   }
 
-  sqlite3_bind_text(stmt, sqlite3_bind_parameter_index(stmt, "@status"), status.c_str(), -1, 0);
-  sqlite3_bind_text(stmt, sqlite3_bind_parameter_index(stmt, "@dev_type"), dev_type.c_str(), -1, 0);
-  sqlite3_bind_text(stmt, sqlite3_bind_parameter_index(stmt, "@id"), id.c_str(), -1, 0);
+  int64_t copied = 0;
+  int64_t total = 0;
+  QueryInt("select (select count(*) from calls) + (select count(*) from recordings);", &copied);
+  QueryInt("select count(*) from calls_v1;", &total);
+  if (copied != total) {
+    Logger::GetLogger()->Log("Failed to migrate " + std::to_string(total - copied) + " of " + std::to_string(total) +
+      " entries", LOG_LVL_ERROR);
+    return false;
+  }
+  return Execute("drop table calls_v1;");
+}
 
-  ret = sqlite3_step(stmt);
-  if (ret != SQLITE_DONE) {
-    switch (ret) {
-      case SQLITE_BUSY:
-        Logger::GetLogger()->Log("Failed to update entry in table: DB is locked.", LOG_LVL_ERROR);
-      break;
-      case SQLITE_ROW:
-        Logger::GetLogger()->Log("Failed to update entry in table: Statement returned data when it should not.",
-          LOG_LVL_ERROR);
-      break;
-      case SQLITE_MISUSE:
-        Logger::GetLogger()->Log("Failed to update entry in table: Misuse detected.", LOG_LVL_ERROR);
-      break;
-      default:
-        Logger::GetLogger()->Log("Failed to update entry in table: Error code " + std::to_string(ret),
-          LOG_LVL_ERROR);
+bool DBClient::StartCampaign() {
+  Statement *statement = GetStatement(STMT_CAMPAIGN);
+  if (statement == nullptr || !Step(statement, "start campaign")) {
+    return false;
+  }
+  campaign = sqlite3_last_insert_rowid(db);
+  campaign_uncommitted = sqlite3_get_autocommit(db) == 0;
+  return true;
+}
+
+void DBClient::ApplyProfile(const DBProfile &profile) {
+  sqlite3_busy_timeout(db, profile.busy_timeout);
+
+  // journal_mode returns the mode which is actually used, WAL is not
+  // available on every file system
+  std::string journal_mode;
+  std::string cmd = "pragma journal_mode = " + profile.journal_mode + ";";
+  sqlite3_exec(db, cmd.c_str(), [](void *mode, int columns, char **values, char **) {
+    if (columns > 0 && values[0] != nullptr) {
+      *static_cast<std::string *>(mode) = values[0];
     }
-    Logger::GetLogger()->Log(std::string(sqlite3_errmsg(db)), LOG_LVL_ERROR);
+    return 0;
+  }, &journal_mode, nullptr);
+  if (strcasecmp(journal_mode.c_str(), profile.journal_mode.c_str()) != 0) {
+    Logger::GetLogger()->Log("Database uses journal mode '" + journal_mode + "' instead of '" +
+      profile.journal_mode + "'", LOG_LVL_WARN);
   }
 
-  sqlite3_finalize(stmt);
+  Execute("pragma synchronous = " + profile.synchronous + ";");
+  Execute("pragma mmap_size = " + std::to_string(profile.mmap_size) + ";");
+  Execute("pragma cache_size = " + std::to_string(profile.cache_size) + ";");
+}
+
+bool DBClient::Execute(std::string cmd) {
+  char *err_msg = nullptr;
+  int ret = sqlite3_exec(db, cmd.c_str(), nullptr, nullptr, &err_msg);
+  if (ret != SQLITE_OK) {
+    Logger::GetLogger()->Log("Failed to execute '" + cmd + "': " + std::string(err_msg != nullptr ? err_msg : ""),
+      LOG_LVL_ERROR);
+    sqlite3_free(err_msg);
+    return false;
+  }
   return true;
 }
 
-bool DBClient::UpdateDuration(std::string id, int duration) {
+bool DBClient::QueryInt(const std::string &cmd, int64_t *value) {
   sqlite3_stmt *stmt = nullptr;
-  int ret = 0;
+  if (sqlite3_prepare_v2(db, cmd.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+    Logger::GetLogger()->Log("Failed to prepare sqlite statement: " + cmd, LOG_LVL_ERROR);
+    Logger::GetLogger()->Log(std::string(sqlite3_errmsg(db)), LOG_LVL_ERROR);
+    return false;
+  }
+  bool found = sqlite3_step(stmt) == SQLITE_ROW;
+  if (found) {
+    *value = sqlite3_column_int64(stmt, 0);
+  }
+  sqlite3_finalize(stmt);
+  return found;
+}
 
-  std::string cmd =
-    "update calls\n"
-    "set duration = @duration\n"
-    "where id = @id;";
+DBClient::Statement *DBClient::GetStatement(StatementType type) {
+  Statement *statement = &statements[type];
+  if (statement->stmt != nullptr) {
+    return statement;
+  }
 
-  ret = sqlite3_prepare_v3(db, cmd.c_str(), -1, 0, &stmt, nullptr);
-  if (ret != SQLITE_OK) {
-    switch (ret) {
-      case SQLITE_BUSY:
-        Logger::GetLogger()->Log("Failed to update entry in table: DB is locked.", LOG_LVL_ERROR);
+  std::string cmd;
+  switch (type) {
+    case STMT_CAMPAIGN:
+      cmd = "insert into campaigns (start_time) values(cast(strftime('%s', 'now') as integer));";
       break;
-      case SQLITE_ROW:
-        Logger::GetLogger()->Log("Failed to update entry in table: Statement returned data when it should not.",
-          LOG_LVL_ERROR);
+    case STMT_RECORD:
+      cmd = "insert into calls (campaign, seq, number, leading_zeros, start_time, duration, status, dev_type) "
+            "values(@campaign, @seq, @number, @leading_zeros, @start_time, @duration, @status, @dev_type) "
+            "on conflict(campaign, seq) do update set "
+            "duration = excluded.duration, status = excluded.status, dev_type = excluded.dev_type;";
       break;
-      case SQLITE_MISUSE:
-        Logger::GetLogger()->Log("Failed to update entry in table: Misuse detected.", LOG_LVL_ERROR);
+    case STMT_RECORDING:
+      cmd = "insert into recordings (path, start_time, duration, status, dev_type, analysis_ms) "
+            "values(@path, cast(strftime('%s', 'now') as integer), @duration, @status, @dev_type, @analysis_ms) "
+            "on conflict(path) do update set "
+            "duration = excluded.duration, status = excluded.status, dev_type = excluded.dev_type, "
+            "analysis_ms = excluded.analysis_ms;";
       break;
-      default:
-        Logger::GetLogger()->Log("Failed to update entry in table: Error code " + std::to_string(ret),
-          LOG_LVL_ERROR);
-    }
+    default:
+      return nullptr;
+  }
+
+  // The statements live as long as the client, SQLITE_PREPARE_PERSISTENT
+  // tells sqlite not to allocate them from its lookaside memory
+  int ret = sqlite3_prepare_v3(db, cmd.c_str(), -1, SQLITE_PREPARE_PERSISTENT, &statement->stmt, nullptr);
+  if (ret != SQLITE_OK) {
+    Logger::GetLogger()->Log("Failed to prepare sqlite statement: " + cmd, LOG_LVL_ERROR);
     Logger::GetLogger()->Log(std::string(sqlite3_errmsg(db)), LOG_LVL_ERROR);
-    return false;
+    sqlite3_finalize(statement->stmt);
+    statement->stmt = nullptr;
+    return nullptr;
   }
 
-  sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@duration"), duration);
-  sqlite3_bind_text(stmt, sqlite3_bind_parameter_index(stmt, "@id"), id.c_str(), -1, 0);
+  // Look up the parameters once instead of by name for every row
+  statement->campaign = sqlite3_bind_parameter_index(statement->stmt, "@campaign");
+  statement->seq = sqlite3_bind_parameter_index(statement->stmt, "@seq");
+  statement->number = sqlite3_bind_parameter_index(statement->stmt, "@number");
+  statement->leading_zeros = sqlite3_bind_parameter_index(statement->stmt, "@leading_zeros");
+  statement->path = sqlite3_bind_parameter_index(statement->stmt, "@path");
+  statement->start_time = sqlite3_bind_parameter_index(statement->stmt, "@start_time");
+  statement->duration = sqlite3_bind_parameter_index(statement->stmt, "@duration");
+  statement->status = sqlite3_bind_parameter_index(statement->stmt, "@status");
+  statement->dev_type = sqlite3_bind_parameter_index(statement->stmt, "@dev_type");
+  statement->analysis_ms = sqlite3_bind_parameter_index(statement->stmt, "@analysis_ms");
+  return statement;
+}
 
-  ret = sqlite3_step(stmt);
+bool DBClient::Step(Statement *statement, const std::string &action) {
+  int ret = sqlite3_step(statement->stmt);
   if (ret != SQLITE_DONE) {
     switch (ret) {
       case SQLITE_BUSY:
-        Logger::GetLogger()->Log("Failed to update entry in table: DB is locked.", LOG_LVL_ERROR);
+        Logger::GetLogger()->Log("Failed to " + action + ": DB is locked.", LOG_LVL_ERROR);
       break;
       case SQLITE_ROW:
-        Logger::GetLogger()->Log("Failed to update entry in table: Statement returned data when it should not.",
+        Logger::GetLogger()->Log("Failed to " + action + ": Statement returned data when it should not.",
           LOG_LVL_ERROR);
       break;
       case SQLITE_MISUSE:
-        Logger::GetLogger()->Log("Failed to update entry in table: Misuse detected.", LOG_LVL_ERROR);
+        Logger::GetLogger()->Log("Failed to " + action + ": Misuse detected.", LOG_LVL_ERROR);
       break;
       default:
-        Logger::GetLogger()->Log("Failed to update entry in table: Error code " + std::to_string(ret),
-          LOG_LVL_ERROR);
+        Logger::GetLogger()->Log("Failed to " + action + ": Error code " + std::to_string(ret), LOG_LVL_ERROR);
     }
     Logger::GetLogger()->Log(std::string(sqlite3_errmsg(db)), LOG_LVL_ERROR);
   }
 
-  sqlite3_finalize(stmt);
-  return true;
+  // Make the statement ready for the next row, the bound strings are not
+  // referenced afterwards
+  sqlite3_reset(statement->stmt);
+  sqlite3_clear_bindings(statement->stmt);
+  return ret == SQLITE_DONE;
 }
@@ -0,0 +1,156 @@
+// Copyright 2020 Barger M., Knoll M., Kofler L.
+
+#include "db_writer.hpp"
+
+#include <chrono> // NOLINT
+#include <iterator>
+#include <utility>
+
+DBWriter::DBWriter(std::string path, const DBProfile &profile, int interval_ms, size_t batch_rows)
+    : db(path, profile), interval_ms(interval_ms), batch_rows(batch_rows > 0 ? batch_rows : 1) {
+  thread = std::thread(&DBWriter::Run, this);
+}
+
+DBWriter::~DBWriter() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stop = true;
+  }
+  wake.notify_one();
+  thread.join();
+}
+
+bool DBWriter::IsOpen() {
+  // Set by the constructor of the client before the writer thread starts
+  return db.IsOpen();
+}
+
+void DBWriter::WriteRecord(const CallRecord &record) {
+  Post({OP_RECORD, record, "", 0});
+}
+
+void DBWriter::WriteRecording(std::string path, CallStatus status, int dev_type, int duration, double analysis_ms) {
+  Operation operation = {OP_RECORDING, CallRecord(), std::move(path), analysis_ms};
+  operation.record.status = status;
+  operation.record.dev_type = dev_type;
+  operation.record.duration = duration;
+  Post(std::move(operation));
+}
+
+void DBWriter::Flush() {
+  std::unique_lock<std::mutex> lock(mutex);
+  uint64_t target = posted;
+  flush_waiters++;
+  wake.notify_one();
+  committed_cond.wait(lock, [this, target] { return done >= target; });
+  flush_waiters--;
+}
+
+uint64_t DBWriter::GetTransactionCount() {
+  std::lock_guard<std::mutex> lock(mutex);
+  return transactions;
+}
+
+uint64_t DBWriter::GetRowCount() {
+  std::lock_guard<std::mutex> lock(mutex);
+  return rows;
+}
+
+void DBWriter::Post(Operation operation) {
+  bool notify;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    pending.push_back(std::move(operation));
+    posted++;
+    // The writer only has to wake up for the first change of a batch, which
+    // starts the interval, and when the batch is full
+    notify = pending.size() == 1 || pending.size() >= batch_rows;
+  }
+  if (notify) {
+    wake.notify_one();
+  }
+}
+
+void DBWriter::Run() {
+  std::vector<Operation> batch;
+  int attempts = 0;
+  std::unique_lock<std::mutex> lock(mutex);
+  while (true) {
+    wake.wait(lock, [this] { return stop || !pending.empty(); });
+    if (pending.empty()) {
+      break;
+    }
+
+    // Collect more changes until the batch is full or the first change has
+    // waited long enough
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(interval_ms);
+    wake.wait_until(lock, deadline, [this] {
+      return stop || flush_waiters > 0 || pending.size() >= batch_rows;
+    });
+
+    batch.swap(pending);
+    lock.unlock();
+    uint64_t applied = 0;
+    bool ok = Apply(batch, &applied);
+    lock.lock();
+
+    if (!ok && ++attempts < DB_WRITER_MAX_ATTEMPTS) {
+      // Try the batch again, ahead of the changes posted in the meantime
+      batch.insert(batch.end(), std::make_move_iterator(pending.begin()), std::make_move_iterator(pending.end()));
+      pending.swap(batch);
+      batch.clear();
+      continue;
+    }
+    if (!ok) {
+      Logger::GetLogger()->Log("Lost " + std::to_string(batch.size()) + " database changes after " +
+        std::to_string(attempts) + " failed transactions", LOG_LVL_ERROR);
+    }
+    attempts = 0;
+
+    done += batch.size();
+    if (applied > 0) {
+      rows += applied;
+      transactions++;
+    }
+    batch.clear();
+    committed_cond.notify_all();
+  }
+}
+
+bool DBWriter::Apply(const std::vector<Operation> &batch, uint64_t *applied) {
+  *applied = 0;
+  if (!db.BeginTransaction()) {
+    Logger::GetLogger()->Log("Failed to start the transaction of " + std::to_string(batch.size()) +
+      " database changes", LOG_LVL_WARN);
+    return false;
+  }
+
+  // A change which fails is logged by the client, the rest of the batch is
+  // still committed
+  uint64_t count = 0;
+  for (const Operation &operation : batch) {
+    const CallRecord &record = operation.record;
+    bool ok = false;
+    switch (operation.type) {
+      case OP_RECORD:
+        ok = db.WriteRecord(record);
+        break;
+      case OP_RECORDING:
+        ok = db.WriteRecording(operation.path, record.status, record.dev_type, record.duration,
+          operation.analysis_ms);
+        break;
+    }
+    if (ok) {
+      count++;
+    }
+  }
+
+  if (!db.CommitTransaction()) {
+    db.RollbackTransaction();
+    Logger::GetLogger()->Log("Failed to commit the transaction of " + std::to_string(batch.size()) +
+      " database changes", LOG_LVL_WARN);
+    return false;
+  }
+  *applied = count;
+  return true;
+}
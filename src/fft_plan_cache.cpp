@@ -0,0 +1,84 @@
+// Copyright 2020 Barger M., Knoll M., Kofler L.
+#include "fft_plan_cache.hpp"
+
+FFTPlanCache::FFTPlanCache() {
+  this->hits = 0;
+  this->misses = 0;
+}
+
+FFTPlanCache::~FFTPlanCache() {
+  for (auto &size_plans : plans) {
+    for (kiss_fftr_cfg cfg : size_plans.second) {
+      kiss_fftr_free(cfg);
+    }
+  }
+}
+
+FFTPlanCache* FFTPlanCache::GetPlanCache() {
+  // Initialization of a static local is thread safe
+  static FFTPlanCache instance;
+  return &instance;
+}
+
+kiss_fftr_cfg FFTPlanCache::Acquire(int nfft) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<kiss_fftr_cfg> &unused = plans[nfft];
+    if (!unused.empty()) {
+      kiss_fftr_cfg cfg = unused.back();
+      unused.pop_back();
+      hits++;
+      return cfg;
+    }
+  }
+
+  // Compute the twiddles outside of the lock
+  misses++;
+  return kiss_fftr_alloc(nfft, 0, nullptr, nullptr);
+}
+
+void FFTPlanCache::Release(int nfft, kiss_fftr_cfg cfg) {
+  if (cfg == nullptr) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex);
+  plans[nfft].push_back(cfg);
+}
+
+uint64_t FFTPlanCache::GetHits() {
+  return hits;
+}
+
+uint64_t FFTPlanCache::GetMisses() {
+  return misses;
+}
+
+FFTArena* FFTArena::GetArena() {
+  thread_local FFTArena arena;
+  return &arena;
+}
+
+FFTScratch* FFTArena::GetScratch(int nfft) {
+  std::map<int, FFTScratch>::iterator it = scratches.find(nfft);
+  if (it != scratches.end()) {
+    return &it->second;
+  }
+
+  FFTScratch &scratch = scratches[nfft];
+  scratch.cfg = FFTPlanCache::GetPlanCache()->Acquire(nfft);
+  scratch.fbuf.resize(nfft / 2 + 1);
+  scratch.mag2buf.resize(nfft / 2 + 1);
+  return &scratch;
+}
+
+FFTArena::~FFTArena() {
+  for (auto &scratch : scratches) {
+    FFTPlanCache::GetPlanCache()->Release(scratch.first, scratch.second.cfg);
+  }
+}
+
+void LogPlanCacheStats() {
+  FFTPlanCache *cache = FFTPlanCache::GetPlanCache();
+  Logger::GetLogger()->Log("FFT plan cache: " + std::to_string(cache->GetHits()) + " hits, " +
+    std::to_string(cache->GetMisses()) + " misses", LOG_LVL_INFO);
+}
@@ -0,0 +1,132 @@
+// Copyright 2020 Barger M., Knoll M., Kofler L.
+
+#include "live_analysis.hpp"
+
+#include <algorithm>
+#include <chrono> // NOLINT
+
+LiveStream::LiveStream() : ring(LIVE_RING_SAMPLES), analyzer(nullptr), verdict(false), worker(-1) {}
+
+void LiveStream::Reset(AudioAnalyzer *analyzer) {
+  ring.Reset();
+  this->analyzer = analyzer;
+  verdict = false;
+}
+
+SPSCRing<int16_t> *LiveStream::GetRing() {
+  return &ring;
+}
+
+AudioAnalyzer *LiveStream::GetAnalyzer() {
+  return analyzer;
+}
+
+bool LiveStream::HasVerdict() {
+  return verdict.load(std::memory_order_acquire);
+}
+
+size_t LiveStream::Drain() {
+  size_t total = 0;
+  const int16_t *samples;
+  size_t len;
+  while ((len = ring.Peek(&samples)) > 0) {
+    // Once the call is classified the samples are discarded, the event thread
+    // reads the analyzer from then on
+    if (!verdict.load(std::memory_order_relaxed) && analyzer != nullptr) {
+      analyzer->Feed(samples, len);
+      if (analyzer->HasVerdict()) {
+        verdict.store(true, std::memory_order_release);
+      }
+    }
+    ring.Consume(len);
+    total += len;
+  }
+  return total;
+}
+
+LiveAnalysisPool::LiveAnalysisPool(int workers) : workers(std::max(1, workers)), max_fill(0), overflow(0) {
+  for (auto &worker : this->workers) {
+    threads.push_back(std::thread(&LiveAnalysisPool::Run, this, &worker));
+  }
+}
+
+LiveAnalysisPool::~LiveAnalysisPool() {
+  {
+    std::lock_guard<std::mutex> lock(stop_mutex);
+    stop = true;
+  }
+  stop_cond.notify_all();
+  for (auto &thread : threads) {
+    thread.join();
+  }
+}
+
+void LiveAnalysisPool::Attach(LiveStream *stream) {
+  size_t best = 0;
+  size_t best_size = SIZE_MAX;
+  for (size_t i = 0; i < workers.size(); i++) {
+    std::lock_guard<std::mutex> lock(workers[i].mutex);
+    if (workers[i].streams.size() < best_size) {
+      best = i;
+      best_size = workers[i].streams.size();
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(workers[best].mutex);
+  stream->worker = best;
+  workers[best].streams.push_back(stream);
+}
+
+void LiveAnalysisPool::Detach(LiveStream *stream) {
+  if (stream->worker < 0) {
+    return;
+  }
+  {
+    // The worker drains its streams with the mutex held, afterwards the
+    // calling thread is the only consumer of the ring
+    Worker &worker = workers[stream->worker];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    worker.streams.erase(std::remove(worker.streams.begin(), worker.streams.end(), stream), worker.streams.end());
+    stream->worker = -1;
+  }
+  stream->Drain();
+
+  SPSCRing<int16_t> *ring = stream->GetRing();
+  size_t fill = ring->GetMaxFill();
+  size_t current = max_fill;
+  while (fill > current && !max_fill.compare_exchange_weak(current, fill)) {}
+  overflow += ring->GetOverflow();
+}
+
+size_t LiveAnalysisPool::GetMaxFill() {
+  return max_fill;
+}
+
+uint64_t LiveAnalysisPool::GetOverflow() {
+  return overflow;
+}
+
+void LiveAnalysisPool::Run(Worker *worker) {
+  while (true) {
+    size_t consumed = 0;
+    {
+      std::lock_guard<std::mutex> lock(worker->mutex);
+      for (LiveStream *stream : worker->streams) {
+        consumed += stream->Drain();
+      }
+    }
+
+    // Sleep if all streams were empty, a stream receives a packet every 20 ms
+    if (consumed == 0) {
+      std::unique_lock<std::mutex> lock(stop_mutex);
+      if (stop_cond.wait_for(lock, std::chrono::milliseconds(LIVE_ANALYSIS_IDLE_MS), [this] { return stop; })) {
+        return;
+      }
+    } else {
+      std::lock_guard<std::mutex> lock(stop_mutex);
+      if (stop) {
+        return;
+      }
+    }
+  }
+}
@@ -4,6 +4,7 @@
 
 Logger* Logger::instance = nullptr;
 std::ofstream Logger::log_file;
+std::mutex Logger::log_mutex;
 const char* Logger::file_name = "log.txt";
 
 Logger::Logger() {
@@ -61,6 +62,7 @@ void Logger::Log(const std::string& message, LogLevel level,  int threadid, std:
   std::string log_lvl_str =  "[" + GetLogLevelString(level) + "] ";
   std::string message_str = thread_id_str + log_lvl_str +  number_str + message + "\n";
   std::string log_message_str = date_str + message_str;
+  std::lock_guard<std::mutex> lock(log_mutex);
   log_file << log_message_str;
   log_file.flush();
 
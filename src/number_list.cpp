@@ -0,0 +1,40 @@
+// Copyright 2020 Barger M., Knoll M., Kofler L.
+
+#include "number_list.hpp"
+
+#include <algorithm>
+
+void NumberList::AddNumber(const std::string &number) {
+  entries.push_back({number_count, 0, 1, 0, false, number});
+  number_count++;
+}
+
+void NumberList::AddRange(int64_t first, int64_t last, size_t width) {
+  size_t count = static_cast<size_t>(last - first) + 1;
+  entries.push_back({number_count, first, count, width, true, ""});
+  number_count += count;
+}
+
+size_t NumberList::Size() const {
+  return number_count;
+}
+
+bool NumberList::Empty() const {
+  return number_count == 0;
+}
+
+std::string NumberList::At(size_t index) const {
+  // Find the last entry which starts at or before index
+  auto entry = std::upper_bound(entries.begin(), entries.end(), index,
+    [](size_t i, const Entry &e) { return i < e.offset; }) - 1;
+
+  if (!entry->range) {
+    return entry->literal;
+  }
+
+  std::string num = std::to_string(entry->first + static_cast<int64_t>(index - entry->offset));
+  if (num.length() < entry->width) {
+    num.insert(0, entry->width - num.length(), '0');
+  }
+  return num;
+}
@@ -0,0 +1,222 @@
+// Copyright 2020 Barger M., Knoll M., Kofler L.
+
+#include "registration_manager.hpp"
+
+#include <chrono> // NOLINT
+
+RegistrationManager::RegistrationManager(eXosip_t *context, std::string username, std::string password,
+                                         std::string uri) {
+  this->context = context;
+  this->username = username;
+  this->password = password;
+  this->server_uri = uri;
+  this->reg_id = -1;
+  this->timeout = 15;
+  this->registered = false;
+  this->answers = 0;
+  this->last_success = false;
+  this->failures = 0;
+  this->stop = false;
+}
+
+RegistrationManager::~RegistrationManager() {
+  Unregister();
+}
+
+bool RegistrationManager::Register() {
+  std::lock_guard<std::mutex> reg_lock(reg_mutex);
+  if (registered) {
+    return true;
+  }
+
+  // A removed registration can be registered again
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stop = false;
+  }
+
+  // Set authentication info if provided
+  if (username != "" && password != "") {
+    eXosip_lock(context);
+    eXosip_add_authentication_info(context, username.c_str(), username.c_str(), password.c_str(), nullptr, nullptr);
+    eXosip_unlock(context);
+  }
+
+  // Build REGISTER message
+  osip_message_t *reg_msg = nullptr;
+  std::string sip_from = "sip:" + username + "@" + server_uri;
+  std::string sip_proxy = "sip:" + server_uri;
+  eXosip_lock(context);
+  reg_id = eXosip_register_build_initial_register(context, sip_from.c_str(), sip_proxy.c_str(), nullptr,
+                                                  REGISTRATION_EXPIRY, &reg_msg);
+  eXosip_unlock(context);
+
+  if (reg_id < 0) {
+    std::string reason;
+    switch (reg_id) {
+      case OSIP_BADPARAMETER: reason = " (bad parameter)"; break;
+      case OSIP_WRONG_STATE: reason = " (wrong state)"; break;
+      case OSIP_NOMEM: reason = " (out of memory)"; break;
+      case OSIP_SYNTAXERROR: reason = " (syntax error)"; break;
+      default: break;
+    }
+    Logger::GetLogger()->Log("Failed to build REGISTER message. Status: " + std::to_string(reg_id) + reason,
+                              LOG_LVL_ERROR);
+    return false;
+  }
+
+  // Send REGISTER message
+  int seen;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    seen = answers;
+  }
+  eXosip_lock(context);
+  int send_status = eXosip_register_send_register(context, reg_id, reg_msg);
+  eXosip_unlock(context);
+  if ( send_status != OSIP_SUCCESS ) {
+    Logger::GetLogger()->Log("Failed to send REGISTER message. Status: " + std::to_string(send_status),
+                              LOG_LVL_ERROR);
+    return false;
+  }
+
+  // Wait for the registration process to complete
+  registered = WaitForAnswer(seen, "Answer to REGISTER message was not received");
+  if (!registered) {
+    Logger::GetLogger()->Log("Registration failed.", LOG_LVL_ERROR);
+    return false;
+  }
+  Logger::GetLogger()->Log("Registration successful.", LOG_LVL_STATUS);
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    failures = 0;
+  }
+  cond.notify_all();
+
+  // Keep the registration alive in the background
+  if (!refresh_thread.joinable()) {
+    refresh_thread = std::thread(&RegistrationManager::RefreshLoop, this);
+  }
+  return true;
+}
+
+void RegistrationManager::Unregister() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stop = true;
+  }
+  cond.notify_all();
+  if (refresh_thread.joinable()) {
+    refresh_thread.join();
+  }
+
+  std::lock_guard<std::mutex> reg_lock(reg_mutex);
+  if (registered) {
+    registered = false;
+    if (Update(0, "Answer to DEREGISTER message was not received")) {
+      Logger::GetLogger()->Log("Successfully closed SIP session.", LOG_LVL_STATUS);
+    }
+  }
+}
+
+bool RegistrationManager::IsRegistered() {
+  return registered;
+}
+
+bool RegistrationManager::WaitForRegistration(const std::atomic<bool> &cancel) {
+  std::unique_lock<std::mutex> lock(mutex);
+  // A signal handler can't notify the condition, so cancel is polled
+  while (!registered && !stop && !cancel && failures < REGISTRATION_MAX_RETRIES) {
+    cond.wait_for(lock, std::chrono::seconds(1));
+  }
+  return registered;
+}
+
+void RegistrationManager::OnEvent(eXosip_event_t *event) {
+  bool success = event->type == EXOSIP_REGISTRATION_SUCCESS;
+  int status = event->response != nullptr ? osip_message_get_status_code(event->response) : 0;
+
+  // Challenges are answered by eXosip_automatic_action(), only the answer
+  // to the authenticated REGISTER is final
+  if (!success && (status == 401 || status == 407)) {
+    return;
+  }
+  if (success && event->response != nullptr) {
+    char *msg = nullptr;
+    size_t buf_size = 0;
+    osip_message_to_str(event->response, &msg, &buf_size);
+    success = (std::string(msg).find("Authorization failure") == std::string::npos);
+    osip_free(msg);
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    answers++;
+    last_success = success;
+  }
+  cond.notify_all();
+}
+
+void RegistrationManager::SetTimeout(int timeout) {
+  this->timeout = timeout;
+}
+
+bool RegistrationManager::Update(int expires, std::string err_msg) {
+  osip_message_t *reg_msg = nullptr;
+  int seen;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    seen = answers;
+  }
+
+  eXosip_lock(context);
+  int status = eXosip_register_build_register(context, reg_id, expires, &reg_msg);
+  if (status >= 0) {
+    status = eXosip_register_send_register(context, reg_id, reg_msg);
+  }
+  eXosip_unlock(context);
+
+  if (status < 0) {
+    Logger::GetLogger()->Log("Failed to send REGISTER message. Status: " + std::to_string(status),
+                              LOG_LVL_ERROR);
+    return false;
+  }
+  return WaitForAnswer(seen, err_msg);
+}
+
+bool RegistrationManager::WaitForAnswer(int seen, std::string err_msg) {
+  std::unique_lock<std::mutex> lock(mutex);
+  if (!cond.wait_for(lock, std::chrono::seconds(timeout), [this, seen] { return answers != seen; })) {
+    Logger::GetLogger()->Log(err_msg, LOG_LVL_WARN);
+    return false;
+  }
+  return last_success;
+}
+
+void RegistrationManager::RefreshLoop() {
+  int interval = REGISTRATION_EXPIRY - REGISTRATION_REFRESH_MARGIN;
+
+  std::unique_lock<std::mutex> lock(mutex);
+  while (!cond.wait_for(lock, std::chrono::seconds(interval), [this] { return stop; })) {
+    lock.unlock();
+    bool success;
+    {
+      std::lock_guard<std::mutex> reg_lock(reg_mutex);
+      success = Update(REGISTRATION_EXPIRY, "Answer to REGISTER refresh was not received");
+      registered = success;
+    }
+    if (success) {
+      Logger::GetLogger()->Log("Registration refreshed.", LOG_LVL_INFO);
+      interval = REGISTRATION_EXPIRY - REGISTRATION_REFRESH_MARGIN;
+    } else {
+      // Retry soon, calls are not placed until the registration is back
+      Logger::GetLogger()->Log("Refreshing the registration failed.", LOG_LVL_ERROR);
+      interval = REGISTRATION_RETRY_INTERVAL;
+    }
+    lock.lock();
+
+    // Wake up the dial threads waiting for the registration
+    failures = success ? 0 : failures + 1;
+    cond.notify_all();
+  }
+}
@@ -2,44 +2,53 @@
 
 #include "rtp_client.hpp"
 
-RTPClient::RTPClient(std::string server_uri, int *local_port, int payload_type, std::string file_name) {
+#include <algorithm>
+#include <utility>
+
+RTPClient::RTPClient(std::string server_uri, int *local_port, int payload_type, std::string file_name,
+                     double max_duration_ms) {
   this->server_uri = server_uri;
   this->remote_port = 4242;
   this->payload_type = payload_type;
   this->file_name = file_name;
 
   this->recv_ts = 0;
+  this->max_duration_ms = max_duration_ms;
+  this->bytes_received = 0;
   this->active = false;
   this->save_data = file_name != "" ? true : false;
 
   if (this->save_data) {
     file.open(file_name, std::ios::out | std::ios::binary);
   }
-  ortp_init();
-  ortp_scheduler_init();
-  ortp_set_log_level_mask(nullptr, 0);
-
-  session = rtp_session_new(RTP_SESSION_SENDRECV);
-  rtp_session_set_scheduling_mode(session, 1);
-  rtp_session_set_blocking_mode(session, 1);
-  rtp_session_set_connected_mode(session, true);
-  rtp_session_set_symmetric_rtp(session, true);
-  rtp_session_set_payload_type(session, payload_type);
-
-  rtp_session_set_remote_addr(session, server_uri.c_str(), remote_port);
+
+  // oRTP itself is initialized once per process by the runtime
+  this->session = nullptr;
+  this->stream = nullptr;
+  this->engine = RTPRuntime::GetRuntime()->GetEngine();
+  if (engine != nullptr && (stream = engine->Open(payload_type)) != nullptr) {
+    *local_port = this->local_port = stream->GetLocalPort();
+    return;
+  }
+  // Fall back to oRTP if the engine is not running or has no free socket
+  engine = nullptr;
+  session = RTPRuntime::GetRuntime()->CreateSession(server_uri, remote_port, payload_type);
   *local_port = this->local_port = rtp_session_get_local_port(session);
 }
 
 RTPClient::~RTPClient() {
-  rtp_session_destroy(session);
-  ortp_exit();
+  if (engine != nullptr) {
+    engine->Close(stream);
+  } else {
+    RTPRuntime::GetRuntime()->DestroySession(session);
+  }
 
   if (file.is_open()) {
     file.close();
   }
 
   // If no data has been received delete the file
-  if (raw_data.size() == 0) {
+  if (bytes_received == 0) {
     std::remove(file_name.c_str());
   }
 }
@@ -47,9 +56,17 @@ RTPClient::~RTPClient() {
 void RTPClient::Init(int remote_port) {
   // Send dummy data to initialize RTP transfer
   this->remote_port = remote_port;
+  this->active = true;
+
+  // The call has been answered, reserve the buffer for the whole recording
+  // and one second of packets still queued when it ends
+  raw_data.reserve(static_cast<size_t>(max_duration_ms / 1000 * RTP_BYTES_PER_SECOND) + RTP_BYTES_PER_SECOND);
+  if (engine != nullptr) {
+    engine->Connect(stream, server_uri, remote_port);
+    return;
+  }
   rtp_session_set_remote_addr(session, server_uri.c_str(), this->remote_port);
   rtp_session_send_with_ts(session, nullptr, 0, 0);
-  this->active = true;
 }
 
 void RTPClient::SendData() {
@@ -59,37 +76,73 @@ void RTPClient::SendData() {
   }
 }
 
-void RTPClient::ReceiveAll() {
+int RTPClient::ReceiveAll(SPSCRing<int16_t> *ring) {
   if (this->active == false) {
     Logger::GetLogger()->Log("Trying to receive on an inactive RTP Session", LOG_LVL_ERROR);
-    return;
+    return 0;
   }
 
-  uint8_t *buffer = new uint8_t[pdu_size];
-  int bytes_rcvd = 0;
-  int bytes_left = 0;
+  size_t offset = raw_data.size();
+  if (engine != nullptr) {
+    stream->Take(&raw_data);
+  } else {
+    int bytes_rcvd = 0;
+    int bytes_left = 0;
+
+    // Get payload data from queue, it is received directly into the raw data
+    // which only keeps the bytes actually received
+    do {
+      size_t size = raw_data.size();
+      raw_data.resize(size + pdu_size);
+      bytes_rcvd = rtp_session_recv_with_ts(session, reinterpret_cast<uint8_t *>(raw_data.data() + size), pdu_size,
+                                            recv_ts, &bytes_left);
+      recv_ts += pdu_size;
+      raw_data.resize(size + (bytes_rcvd > 0 ? bytes_rcvd : 0));
+
+      if (bytes_rcvd > 0) {
+        stats.packets++;
+        stats.bytes += bytes_rcvd;
+      }
+    } while (bytes_rcvd > 0);
+  }
 
-  // Get payload data from queue
-  do {
-    bytes_rcvd = rtp_session_recv_with_ts(session, buffer, pdu_size, recv_ts, &bytes_left);
-    recv_ts += pdu_size;
+  Process(offset, ring);
+  bytes_received += raw_data.size() - offset;
+  return raw_data.size() - offset;
+}
 
-    if (bytes_rcvd != 0) {
-      // Write data to file
-      if (save_data) {
-        file.write(reinterpret_cast<char *>(buffer), pdu_size);
-        // file.flush();
-      }
+std::vector<int8_t> RTPClient::TakeRawData() {
+  return std::move(raw_data);
+}
 
-      // Write data to vector
-      for (int i = 0; i < pdu_size; i++) {
-        raw_data.push_back(buffer[i]);
-      }
-    }
-  } while (bytes_rcvd != 0);
-  free(buffer);
+RTPStreamStats RTPClient::GetStats() {
+  return engine != nullptr ? stream->GetStats() : stats;
 }
 
-std::vector<int8_t> RTPClient::GetRawData() {
-  return raw_data;
+void RTPClient::Process(size_t offset, SPSCRing<int16_t> *ring) {
+  size_t len = raw_data.size() - offset;
+  if (len == 0) {
+    return;
+  }
+  const int8_t *data = raw_data.data() + offset;
+
+  // Write data to file
+  if (save_data) {
+    file.write(reinterpret_cast<const char *>(data), len);
+  }
+
+  // Decode straight into the ring, so the call can be analyzed while it is
+  // still running. Samples which do not fit are counted by the ring.
+  if (ring != nullptr) {
+    int16_t *samples;
+    size_t space;
+    while (len > 0 && (space = ring->Reserve(&samples)) > 0) {
+      size_t n = std::min(space, len);
+      DecodeAlaw(data, n, samples);
+      ring->Commit(n);
+      data += n;
+      len -= n;
+    }
+    ring->Drop(len);
+  }
 }
@@ -0,0 +1,231 @@
+// Copyright 2020 Barger M., Knoll M., Kofler L.
+
+#include "rtp_engine.hpp"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include "log.hpp"
+
+// Size of the fixed RTP header
+#define RTP_HEADER_SIZE 12
+
+RTPStream::RTPStream(int fd, int local_port, int payload_type)
+    : fd(fd), local_port(local_port), payload_type(payload_type) {
+  memset(&remote, 0, sizeof(remote));
+}
+
+size_t RTPStream::Take(std::vector<int8_t> *out) {
+  std::lock_guard<std::mutex> lock(mutex);
+  size_t len = pending.size();
+  out->insert(out->end(), pending.begin(), pending.end());
+  pending.clear();
+  return len;
+}
+
+RTPStreamStats RTPStream::GetStats() {
+  std::lock_guard<std::mutex> lock(mutex);
+  return stats;
+}
+
+int RTPStream::GetLocalPort() const {
+  return local_port;
+}
+
+void RTPStream::Deliver(const uint8_t *packet, size_t len) {
+  std::lock_guard<std::mutex> lock(mutex);
+  if (len < RTP_HEADER_SIZE || (packet[0] >> 6) != 2) {
+    stats.dropped++;
+    return;
+  }
+
+  // Skip CSRC list and header extension, strip padding
+  size_t header = RTP_HEADER_SIZE + 4 * (packet[0] & 0x0f);
+  if ((packet[0] & 0x10) && len >= header + 4) {
+    header += 4 + 4 * ((packet[header + 2] << 8) | packet[header + 3]);
+  } else if (packet[0] & 0x10) {
+    header = len + 1;
+  }
+  size_t padding = (packet[0] & 0x20) && len > header ? packet[len - 1] : 0;
+  if (header > len || padding > len - header || (packet[1] & 0x7f) != payload_type) {
+    stats.dropped++;
+    return;
+  }
+  len -= padding;
+
+  uint16_t seq = (packet[2] << 8) | packet[3];
+  uint32_t packet_ssrc = (packet[8] << 24) | (packet[9] << 16) | (packet[10] << 8) | packet[11];
+  if (!have_ssrc) {
+    // Lock onto the first source, as oRTP does in symmetric mode
+    have_ssrc = true;
+    ssrc = packet_ssrc;
+    next_seq = seq;
+  } else if (packet_ssrc != ssrc) {
+    stats.dropped++;
+    return;
+  }
+
+  int16_t gap = static_cast<int16_t>(seq - next_seq);
+  if (gap >= 0) {
+    stats.lost += gap;
+    next_seq = seq + 1;
+  } else if (stats.lost > 0) {
+    // A late packet, it was counted as lost before
+    stats.lost--;
+  }
+
+  stats.packets++;
+  stats.bytes += len - header;
+  pending.insert(pending.end(), packet + header, packet + len);
+}
+
+RTPEngine::RTPEngine() {
+  if ( (epoll_fd = epoll_create1(EPOLL_CLOEXEC)) < 0 ) {
+    Logger::GetLogger()->Log("epoll_create1() failed: " + std::string(strerror(errno)), LOG_LVL_FATAL);
+    throw "Fatal error in RTPEngine()";
+  }
+
+  for (int i = 0; i < RTP_BATCH_SIZE; i++) {
+    iovecs[i].iov_base = buffers[i];
+    iovecs[i].iov_len = RTP_MAX_PACKET_SIZE;
+    memset(&messages[i], 0, sizeof(messages[i]));
+    messages[i].msg_hdr.msg_iov = &iovecs[i];
+    messages[i].msg_hdr.msg_iovlen = 1;
+  }
+
+  running = true;
+  thread = std::thread(&RTPEngine::Loop, this);
+}
+
+RTPEngine::~RTPEngine() {
+  running = false;
+  if (thread.joinable()) {
+    thread.join();
+  }
+  for (RTPStream *stream : streams) {
+    close(stream->fd);
+    delete stream;
+  }
+  close(epoll_fd);
+}
+
+RTPStream *RTPEngine::Open(int payload_type) {
+  int fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_UDP);
+  if (fd < 0) {
+    Logger::GetLogger()->Log("Failed to open RTP socket: " + std::string(strerror(errno)), LOG_LVL_ERROR);
+    return nullptr;
+  }
+
+  // Let the kernel choose a free port
+  sockaddr_in local;
+  memset(&local, 0, sizeof(local));
+  local.sin_family = AF_INET;
+  local.sin_addr.s_addr = htonl(INADDR_ANY);
+  local.sin_port = 0;
+  socklen_t local_len = sizeof(local);
+  if (bind(fd, reinterpret_cast<sockaddr *>(&local), sizeof(local)) != 0 ||
+      getsockname(fd, reinterpret_cast<sockaddr *>(&local), &local_len) != 0) {
+    Logger::GetLogger()->Log("Failed to bind RTP socket: " + std::string(strerror(errno)), LOG_LVL_ERROR);
+    close(fd);
+    return nullptr;
+  }
+
+  RTPStream *stream = new RTPStream(fd, ntohs(local.sin_port), payload_type);
+  epoll_event event;
+  memset(&event, 0, sizeof(event));
+  event.events = EPOLLIN;
+  event.data.ptr = stream;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0) {
+    Logger::GetLogger()->Log("Failed to add RTP socket to epoll: " + std::string(strerror(errno)), LOG_LVL_ERROR);
+    close(fd);
+    delete stream;
+    return nullptr;
+  }
+  streams.insert(stream);
+  return stream;
+}
+
+bool RTPEngine::Connect(RTPStream *stream, std::string host, int port) {
+  addrinfo hints;
+  addrinfo *result = nullptr;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_DGRAM;
+  if (getaddrinfo(host.c_str(), nullptr, &hints, &result) != 0 || result == nullptr) {
+    Logger::GetLogger()->Log("Failed to resolve RTP target " + host, LOG_LVL_ERROR);
+    return false;
+  }
+  stream->remote = *reinterpret_cast<sockaddr_in *>(result->ai_addr);
+  stream->remote.sin_port = htons(port);
+  freeaddrinfo(result);
+
+  // Empty packet with version 2 and our payload type
+  uint8_t packet[RTP_HEADER_SIZE];
+  memset(packet, 0, sizeof(packet));
+  packet[0] = 0x80;
+  packet[1] = stream->payload_type & 0x7f;
+  if (sendto(stream->fd, packet, sizeof(packet), 0, reinterpret_cast<sockaddr *>(&stream->remote),
+             sizeof(stream->remote)) < 0) {
+    Logger::GetLogger()->Log("Failed to send RTP packet: " + std::string(strerror(errno)), LOG_LVL_WARN);
+    return false;
+  }
+  return true;
+}
+
+void RTPEngine::Close(RTPStream *stream) {
+  if (stream == nullptr) {
+    return;
+  }
+  // The engine thread holds the mutex while delivering, so it is done with
+  // the stream when we get it
+  std::lock_guard<std::mutex> lock(mutex);
+  epoll_ctl(epoll_fd, EPOLL_CTL_DEL, stream->fd, nullptr);
+  close(stream->fd);
+  streams.erase(stream);
+  delete stream;
+}
+
+size_t RTPEngine::GetStreamCount() {
+  std::lock_guard<std::mutex> lock(mutex);
+  return streams.size();
+}
+
+void RTPEngine::Loop() {
+  epoll_event events[RTP_BATCH_SIZE];
+  while (running) {
+    int ready = epoll_wait(epoll_fd, events, RTP_BATCH_SIZE, RTP_ENGINE_WAIT_MS);
+    if (ready < 0) {
+      if (errno != EINTR) {
+        Logger::GetLogger()->Log("epoll_wait() failed: " + std::string(strerror(errno)), LOG_LVL_ERROR);
+      }
+      continue;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (int i = 0; i < ready; i++) {
+      RTPStream *stream = static_cast<RTPStream *>(events[i].data.ptr);
+      // The stream may have been closed after epoll_wait() returned
+      if (streams.count(stream) != 0) {
+        Drain(stream);
+      }
+    }
+  }
+}
+
+void RTPEngine::Drain(RTPStream *stream) {
+  int received;
+  do {
+    received = recvmmsg(stream->fd, messages, RTP_BATCH_SIZE, MSG_DONTWAIT, nullptr);
+    for (int i = 0; i < received; i++) {
+      stream->Deliver(buffers[i], messages[i].msg_len);
+    }
+  } while (received == RTP_BATCH_SIZE);
+}
@@ -0,0 +1,76 @@
+// Copyright 2020 Barger M., Knoll M., Kofler L.
+
+#include "rtp_runtime.hpp"
+
+#include "log.hpp"
+
+RTPRuntime* RTPRuntime::instance = nullptr;
+std::mutex RTPRuntime::instance_mutex;
+
+RTPRuntime::RTPRuntime() : sessions(0), engine(nullptr) {
+  ortp_init();
+  ortp_scheduler_init();
+  ortp_set_log_level_mask(nullptr, 0);
+}
+
+RTPRuntime::~RTPRuntime() {
+  delete engine.load();
+  ortp_exit();
+}
+
+RTPRuntime* RTPRuntime::GetRuntime() {
+  std::lock_guard<std::mutex> lock(instance_mutex);
+  if (instance == nullptr) {
+    instance = new RTPRuntime();
+  }
+  return instance;
+}
+
+void RTPRuntime::Shutdown() {
+  std::lock_guard<std::mutex> lock(instance_mutex);
+  if (instance == nullptr) {
+    return;
+  }
+  RTPEngine *engine = instance->engine;
+  size_t active = instance->sessions + (engine != nullptr ? engine->GetStreamCount() : 0);
+  if (active > 0) {
+    Logger::GetLogger()->Log("Shutting down RTP with " + std::to_string(active) + " active sessions", LOG_LVL_WARN);
+  }
+  delete instance;
+  instance = nullptr;
+}
+
+RtpSession *RTPRuntime::CreateSession(std::string server_uri, int remote_port, int payload_type) {
+  RtpSession *session = rtp_session_new(RTP_SESSION_SENDRECV);
+  rtp_session_set_scheduling_mode(session, 1);
+  rtp_session_set_blocking_mode(session, 1);
+  rtp_session_set_connected_mode(session, true);
+  rtp_session_set_symmetric_rtp(session, true);
+  rtp_session_set_payload_type(session, payload_type);
+  rtp_session_set_remote_addr(session, server_uri.c_str(), remote_port);
+  sessions++;
+  return session;
+}
+
+void RTPRuntime::DestroySession(RtpSession *session) {
+  if (session == nullptr) {
+    return;
+  }
+  rtp_session_destroy(session);
+  sessions--;
+}
+
+int RTPRuntime::GetSessionCount() {
+  return sessions;
+}
+
+void RTPRuntime::StartEngine() {
+  std::lock_guard<std::mutex> lock(instance_mutex);
+  if (engine == nullptr) {
+    engine = new RTPEngine();
+  }
+}
+
+RTPEngine *RTPRuntime::GetEngine() {
+  return engine;
+}
@@ -2,151 +2,37 @@
 
 #include "sip_client.hpp"
 
-SIPClient::SIPClient(std::string username, std::string password, std::string uri, int port, int threadid) {
-  this->context = nullptr;
-  this->last_event = nullptr;
-  this->reg_msg = nullptr;
-  this->threadid = threadid;
-
-  // Initialize context
-  if ( (context = eXosip_malloc()) == nullptr ) {
-    Logger::GetLogger()->Log("eXosip_malloc() failed.", LOG_LVL_FATAL, threadid);
-    throw "Fatal error in SIPClient()";
-  }
+#include <utility>
 
-  if ( eXosip_init(context) != 0 ) {
-    Logger::GetLogger()->Log("eXosip_init() failed", LOG_LVL_FATAL, threadid);
-    throw "Fatal error in SIPClient()";
-  }
+SIPClient::SIPClient(CallManager *manager) {
+  this->manager = manager;
+  this->context = manager->GetContext();
 
   // Set data
-  this->username = username;
-  this->password = password;
-  this->server_uri = uri;
-  this->reg_id = -1;
+  this->username = manager->GetUsername();
+  this->server_uri = manager->GetServerUri();
   this->call_id = -1;
   this->dial_id = -1;
-  this->registered = false;
+  this->state = CALL_IDLE;
+  this->end = END_NONE;
+  this->timer = 0;
+  this->poll_timer = 0;
+  this->max_call_duration = 0;
+  this->rtp_remote_port = -1;
+  this->rtp = nullptr;
+  this->live = nullptr;
+  this->answered = false;
+  this->call_duration = 0;
   this->timeout = 15;
-
-  // Set User Agent
-  eXosip_set_user_agent(this->context, "swd");
-
-  // Start listening socket for SIP
-  if ( eXosip_listen_addr(context, IPPROTO_UDP, nullptr, port, AF_INET, 0) != 0 ) {
-    Logger::GetLogger()->Log("Failed to open UDP socket", LOG_LVL_ERROR, threadid);
-    throw "Fatal error in SIPClient()";
-  }
 }
 
 SIPClient::~SIPClient() {
-  // Terminate active call
-  TerminateCall();
-
-  // Deregister at the server
-  if (registered) {
-    eXosip_lock(context);
-    if ( eXosip_register_build_register(context, reg_id, 0, &reg_msg) < 0 ) {
-      eXosip_unlock(context);
-      Logger::GetLogger()->Log("Failed to build UNREGISTER message.", LOG_LVL_ERROR, threadid);
-      return;
-    }
-
-    // Send de-registration message
-    int send_status = eXosip_register_send_register(context, reg_id, reg_msg);
-    eXosip_unlock(context);
-    if ( send_status != OSIP_SUCCESS ) {
-      Logger::GetLogger()->Log(
-          "Failed to send UNREGISTER message. Status: " + std::to_string(send_status), LOG_LVL_ERROR, threadid);
-      return;
-    }
-
-    // Wait for the de-registration process to complete
-    WaitForEvent(EXOSIP_REGISTRATION_SUCCESS, "Answer to DEREGISTER message was not received");
-
-    Logger::GetLogger()->Log("Successfully closed SIP session.", LOG_LVL_STATUS, threadid);
-  }
-
-  // Free memory
-  eXosip_event_free(last_event);
-  eXosip_quit(context);
-}
-
-bool SIPClient::Register() {
-  // Update Registration if there is an active Session
-  if (registered) {
-    eXosip_lock(context);
-    int status = eXosip_register_build_register(context, reg_id, 300, &reg_msg);
-    if (status < 0) {
-      Logger::GetLogger()->Log("Failed to update Registration: " + std::to_string(status), LOG_LVL_ERROR);
-      registered = false;
-    }
-
-  eXosip_register_send_register(context, reg_id, reg_msg);
-    eXosip_unlock(context);
-    return registered;
-  }
-
-  // Else make new Registration
-  // Set authentication info if provided
-  if (username != "" && password != "") {
-    eXosip_lock(context);
-    eXosip_add_authentication_info(context, username.c_str(), username.c_str(), password.c_str(), nullptr, nullptr);
-    eXosip_unlock(context);
-  }
-
-  // Build REGISTER message
-  eXosip_lock(context);
-  std::string sip_from = "sip:" + username + "@" + server_uri;
-  std::string sip_proxy = "sip:" + server_uri;
-  reg_id = eXosip_register_build_initial_register(context, sip_from.c_str(), sip_proxy.c_str(), nullptr, 300,
-                                                  &reg_msg);
-
-  eXosip_unlock(context);
-
-  if (reg_id < 0) {
-    Logger::GetLogger()->Log("Failed to build REGISTER message. Status: " + std::to_string(reg_id),
-                              LOG_LVL_ERROR, threadid);
-    switch (reg_id) {
-      case OSIP_BADPARAMETER: std::cout << "BAD OSIP_BADPARAMETER" << std::endl; break;
-      case OSIP_WRONG_STATE: std::cout << "OSIP_WRONG_STATE" << std::endl; break;
-      case OSIP_NOMEM: std::cout << "OSIP_NOMEM" << std::endl; break;
-      case OSIP_SYNTAXERROR: std::cout << "OSIP_SYNTAXERROR" << std::endl; break;
-      default: std::cout << "NONE" <<std::endl; break;
-    }
-    return false;
-  }
-
-  // Send REGISTER message
-  eXosip_lock(context);
-  int send_status = eXosip_register_send_register(context, reg_id, reg_msg);
-  eXosip_unlock(context);
-  if ( send_status != OSIP_SUCCESS ) {
-    Logger::GetLogger()->Log("Failed to send REGISTER message. Status: " + std::to_string(send_status),
-                              LOG_LVL_ERROR, threadid);
-    return false;
-  }
-
-  // Wait for the registration process to complete
-  registered = WaitForEvent(EXOSIP_REGISTRATION_SUCCESS, "Answer to REGISTER message was not received");
-  char *msg = nullptr;
-  size_t buf_size = 0;
-  if (last_event != nullptr) {
-    osip_message_to_str(last_event->response, &msg, &buf_size);
-    registered = (std::string(msg).find("Authorization failure") == std::string::npos);
-  }
-  delete msg;
-
-  if (registered) {
-    Logger::GetLogger()->Log("Registration successful.", LOG_LVL_STATUS, threadid);
-  } else {
-    Logger::GetLogger()->Log("Registration failed.", LOG_LVL_ERROR, threadid);
-  }
-  return registered;
+  delete rtp;
 }
 
-bool SIPClient::Invite(std::string tel_nr, double max_call_duration, bool save_data, int *call_duration) {
-  if (!registered) {
+bool SIPClient::Invite(std::string tel_nr, double max_call_duration, bool save_data, LiveStream *live,
+                       CallCompletion done) {
+  if (!manager->IsRegistered()) {
     return false;
   }
   // Build INVITE message
@@ -158,20 +44,27 @@ bool SIPClient::Invite(std::string tel_nr, double max_call_duration, bool save_d
 
   if (build_status != 0) {
     Logger::GetLogger()->Log("Failed to build INVITE message. Status: " +
-                      std::to_string(build_status), LOG_LVL_ERROR, threadid, tel_nr);
+                      std::to_string(build_status), LOG_LVL_ERROR, 0, tel_nr);
     return false;
   }
 
+  // The events of the call are processed as soon as the INVITE has been
+  // sent, they wait for the mutex until the call is set up
+  std::lock_guard<std::mutex> lock(mutex);
+  this->tel_nr = tel_nr;
+  this->max_call_duration = max_call_duration;
+  this->live = live;
+  this->done = std::move(done);
+
   // Add SDP body to message
   osip_message_set_supported(invite_msg, "100rel");
   int rtp_local_port = -1;
-  int rtp_remote_port = 4242;   // This is a dummy to allow random allocation
   char local_ip[128];
   eXosip_guess_localip(context, AF_INET, local_ip, 128);
 
   // Start RTP Client
   std::string filename = save_data ? "rtp_dump_" + tel_nr : "";
-  RTPClient rtp = RTPClient(server_uri, &rtp_local_port, 8, filename);
+  rtp = new RTPClient(server_uri, &rtp_local_port, 8, filename, max_call_duration);
 
   std::string sdp_body =
     "v=0\r\n"
@@ -185,88 +78,225 @@ bool SIPClient::Invite(std::string tel_nr, double max_call_duration, bool save_d
   osip_message_set_content_type(invite_msg, "application/sdp");
 
   // Send INVITE message
-  Logger::GetLogger()->Log("Starting call", LOG_LVL_STATUS, threadid, tel_nr);
-  eXosip_t *call_context = nullptr;
-  eXosip_lock(context);
-  call_id = eXosip_call_send_initial_invite(context, invite_msg);
-  if (call_id <= 0) {
-    eXosip_unlock(context);
+  Logger::GetLogger()->Log("Starting call", LOG_LVL_STATUS, 0, tel_nr);
+  int cid = manager->SendInvite(invite_msg, this);
+  if (cid <= 0) {
+    delete rtp;
+    rtp = nullptr;
     return false;
   }
+  call_id = cid;
+  SetState(CALL_INVITING);
+  return true;
+}
 
-  eXosip_call_set_reference(context, call_id, call_context);
-  eXosip_unlock(context);
-
-  // Get Call data by waiting for the first ring or a call request failure (auth)
+void SIPClient::OnEvent(eXosip_event_t *event) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    Logger::GetLogger()->Log(EventToString(event->type), LOG_LVL_INFO, 0, tel_nr);
+    if (event->did > 0) {
+      dial_id = event->did;
+    }
+    if (state == CALL_IDLE) {
+      return;
+    }
 
-  // Received no auth, this can happen but is weird
-  if ( WaitForEvent(EXOSIP_CALL_REQUESTFAILURE, "Received no AUTH for INVITE") == false ) {
-    if (last_event != nullptr) {
-      dial_id = last_event->did;
+    // The event only selects the next state, SetState() runs its actions
+    switch (event->type) {
+      case EXOSIP_CALL_PROCEEDING:
+        if (state == CALL_INVITING) {
+          SetState(CALL_PROCEEDING);
+        }
+        break;
+      case EXOSIP_CALL_RINGING:
+        if (state == CALL_INVITING || state == CALL_PROCEEDING) {
+          SetState(CALL_RINGING);
+        }
+        break;
+      case EXOSIP_CALL_ANSWERED: {
+        // Acknowledge the answer, also if it is retransmitted
+        osip_message_t *ack = nullptr;
+        eXosip_lock(context);
+        if (eXosip_call_build_ack(context, event->did, &ack) == OSIP_SUCCESS) {
+          eXosip_call_send_ack(context, event->did, ack);
+        }
+        eXosip_unlock(context);
+
+        if (state != CALL_RECORDING) {
+          rtp_remote_port = ParseSDPResponse(event->response);
+          SetState(CALL_ANSWERED);
+        }
+        break;
+      }
+      case EXOSIP_CALL_REQUESTFAILURE: {
+        // Challenges are answered by eXosip_automatic_action()
+        int status = event->response != nullptr ? osip_message_get_status_code(event->response) : 0;
+        if (status != 401 && status != 407) {
+          SetState(CALL_TERMINATING, END_REJECTED);
+        }
+        break;
+      }
+      case EXOSIP_CALL_NOANSWER:
+      case EXOSIP_CALL_SERVERFAILURE:
+      case EXOSIP_CALL_GLOBALFAILURE:
+        SetState(CALL_TERMINATING, END_REJECTED);
+        break;
+      case EXOSIP_CALL_CANCELLED:
+      case EXOSIP_CALL_CLOSED:
+      case EXOSIP_CALL_RELEASED:
+        SetState(CALL_TERMINATING, state == CALL_RECORDING ? END_CLOSED : END_REJECTED);
+        break;
+      default:
+        break;
     }
-    if ( WaitForEvent(EXOSIP_CALL_PROCEEDING, "Called number can not be invited") == false ) {
-      return false;
+    if (state != CALL_IDLE) {
+      return;
     }
   }
-  dial_id = last_event->did;
-
-  // Wait for the opposite site to pick up
-  if ( WaitForEvent(EXOSIP_CALL_ANSWERED, "") == true ) {
-    call_id = last_event->cid;
-    dial_id = last_event->did;
-    Logger::GetLogger()->Log("Invite has been accepted.", LOG_LVL_STATUS, threadid, tel_nr);
-
-    rtp_remote_port = ParseSDPResponse(last_event->response);
-    if (rtp_remote_port == -1) {
-      Logger::GetLogger()->Log("Did not receive valid RTP target port or payload type.", LOG_LVL_WARN,
-                                threadid, tel_nr);
-      return false;
+  Complete();
+}
+
+void SIPClient::OnTimeout(TimingWheel::TimerId id) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (id == poll_timer) {
+      poll_timer = 0;
+      Poll();
+    } else if (id == timer) {
+      timer = 0;
+      switch (state) {
+        case CALL_INVITING:
+        case CALL_PROCEEDING:
+        case CALL_RINGING:
+          SetState(CALL_TERMINATING, END_NO_ANSWER);
+          break;
+        case CALL_RECORDING:
+          SetState(CALL_TERMINATING, END_DURATION);
+          break;
+        default:
+          break;
+      }
+    }
+    // Also ignores the timer of a state which has already been left
+    if (state != CALL_IDLE) {
+      return;
     }
-  } else {
-    Logger::GetLogger()->Log("Answer to INVITE message was not received", LOG_LVL_STATUS, threadid, tel_nr);
-    // Call has not been answered
-    TerminateCall();
-    return false;
   }
+  Complete();
+}
 
-  // Call Handling and Data Retrieval
-  rtp.Init(rtp_remote_port);
-
-  // Wait for the given amount of milliseconds or until call is closed
-  std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
-  std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - begin;
-
-  while (elapsed.count() < max_call_duration) {
-    if (WaitForEvent(EXOSIP_CALL_CLOSED, "", 0, 500)) {
-      Logger::GetLogger()->Log("Call was closed by remote side.", LOG_LVL_STATUS, threadid, tel_nr);
-      call_id = -1;
-      dial_id = -1;
-      break;
-    }
+void SIPClient::Poll() {
+  if (state != CALL_RECORDING) {
+    return;
+  }
+  rtp->ReceiveAll(live != nullptr ? live->GetRing() : nullptr);
+
+  // Hang up early if the line type is already known
+  if (live != nullptr && live->HasVerdict()) {
+    Logger::GetLogger()->Log(live->GetAnalyzer()->GetReadableLineType() + " detected, hanging up early.",
+                             LOG_LVL_STATUS, 0, tel_nr);
+    SetState(CALL_TERMINATING, END_VERDICT);
+    return;
+  }
+  poll_timer = manager->StartTimer(call_id, RTP_POLL_INTERVAL_MS);
+}
 
-    rtp.ReceiveAll();
-    elapsed = std::chrono::steady_clock::now() - begin;
+void SIPClient::StartRecording() {
+  Logger::GetLogger()->Log("Invite has been accepted.", LOG_LVL_STATUS, 0, tel_nr);
+  if (rtp_remote_port == -1) {
+    Logger::GetLogger()->Log("Did not receive valid RTP target port or payload type.", LOG_LVL_WARN, 0, tel_nr);
+    SetState(CALL_TERMINATING, END_NO_MEDIA);
+    return;
   }
-  *call_duration = static_cast<int> (elapsed.count() / 1000.f);
-  rtp.ReceiveAll();
-  call_data = rtp.GetRawData();
 
-  Logger::GetLogger()->Log("Terminating call", LOG_LVL_STATUS, threadid, tel_nr);
-  TerminateCall();
-  return true;
+  // Call Handling and Data Retrieval
+  rtp->Init(rtp_remote_port);
+  answered = true;
+  begin = std::chrono::steady_clock::now();
+  SetState(CALL_RECORDING);
 }
 
-void SIPClient::TerminateCall() {
-  if (call_id != -1) {
+void SIPClient::Terminate() {
+  if (answered) {
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - begin;
+    call_duration = static_cast<int> (elapsed.count() / 1000.f);
+    rtp->ReceiveAll(live != nullptr ? live->GetRing() : nullptr);
+    call_data = rtp->TakeRawData();
+    RTPStreamStats rtp_stats = rtp->GetStats();
+    Logger::GetLogger()->Log("RTP: " + std::to_string(rtp_stats.packets) + " packets, " +
+                              std::to_string(rtp_stats.bytes) + " bytes, " + std::to_string(rtp_stats.lost) +
+                              " lost, " + std::to_string(rtp_stats.dropped) + " dropped", LOG_LVL_INFO, 0, tel_nr);
+    if (end == END_CLOSED) {
+      Logger::GetLogger()->Log("Call was closed by remote side.", LOG_LVL_STATUS, 0, tel_nr);
+    } else {
+      Logger::GetLogger()->Log("Terminating call", LOG_LVL_STATUS, 0, tel_nr);
+    }
+  } else if (end == END_NO_ANSWER) {
+    Logger::GetLogger()->Log("Answer to INVITE message was not received", LOG_LVL_STATUS, 0, tel_nr);
+  } else if (end == END_REJECTED) {
+    Logger::GetLogger()->Log("Called number can not be invited", LOG_LVL_WARN, 0, tel_nr);
+  }
+
+  // A call which has been closed by the remote side needs no BYE
+  if (end != END_CLOSED) {
     eXosip_lock(context);
     int status = eXosip_call_terminate(context, call_id, dial_id);
     if (status < 0 && status != -3) {
-      Logger::GetLogger()->Log("Failed to build BYE message: " + std::to_string(status), LOG_LVL_WARN);
+      Logger::GetLogger()->Log("Failed to build BYE message: " + std::to_string(status), LOG_LVL_WARN, 0, tel_nr);
     }
     eXosip_unlock(context);
+  }
+
+  manager->RemoveCall(call_id);
+  delete rtp;
+  rtp = nullptr;
+  SetState(CALL_IDLE);
+}
+
+void SIPClient::Complete() {
+  // The callback may delete the client, so it is moved out first
+  CallCompletion callback = std::move(done);
+  done = nullptr;
+  callback(this);
+}
+
+void SIPClient::SetState(CallState state, CallEnd end) {
+  Logger::GetLogger()->Log(StateToString(this->state) + " -> " + StateToString(state), LOG_LVL_INFO, 0, tel_nr);
+  this->state = state;
+  if (end != END_NONE) {
+    this->end = end;
+  }
 
-    call_id = -1;
-    dial_id = -1;
+  // Every state has at most one timer, the recording also reads the stream
+  if (timer != 0) {
+    manager->CancelTimer(timer);
+    timer = 0;
+  }
+  if (poll_timer != 0) {
+    manager->CancelTimer(poll_timer);
+    poll_timer = 0;
+  }
+
+  // Actions of the new state, the answer and the termination move on to the
+  // next state by themselves
+  switch (state) {
+    case CALL_INVITING:
+    case CALL_PROCEEDING:
+    case CALL_RINGING:
+      timer = manager->StartTimer(call_id, timeout * 1000);
+      break;
+    case CALL_ANSWERED:
+      StartRecording();
+      break;
+    case CALL_RECORDING:
+      timer = manager->StartTimer(call_id, static_cast<int>(max_call_duration));
+      poll_timer = manager->StartTimer(call_id, RTP_POLL_INTERVAL_MS);
+      break;
+    case CALL_TERMINATING:
+      Terminate();
+      break;
+    default:
+      break;
   }
 }
 
@@ -274,54 +304,40 @@ void SIPClient::SetTimeout(int timeout) {
   this->timeout = timeout;
 }
 
-std::vector<int8_t> SIPClient::GetCallData() {
-  return call_data;
+std::string SIPClient::GetNumber() {
+  std::lock_guard<std::mutex> lock(mutex);
+  return tel_nr;
 }
 
-bool SIPClient::WaitForEvent(eXosip_event_type_t event_type, std::string err_msg, int timeout_s, int timeout_ms) {
-  const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
-  std::chrono::steady_clock::time_point curr_time = std::chrono::steady_clock::now();
-  const double timeout = timeout_s * 1000 + timeout_ms;
-
-  do {
-    // Check if the timeout has been reached
-    curr_time = std::chrono::steady_clock::now();
-    if ( (std::chrono::duration<double, std::milli>(curr_time - begin)).count() >= timeout ) {
-    if (err_msg != "") {
-        Logger::GetLogger()->Log(err_msg, LOG_LVL_WARN, threadid);
-      }
-      return false;
-    }
-
-    // Receive the current event
-    last_event = eXosip_event_wait(context, timeout_s, timeout_ms);
-    if (last_event == nullptr) {
-      if (err_msg != "") {
-        Logger::GetLogger()->Log(err_msg, LOG_LVL_WARN, threadid);
-      }
-      return false;
-    }
+bool SIPClient::IsAnswered() {
+  std::lock_guard<std::mutex> lock(mutex);
+  return answered;
+}
 
-    // Process the event with the default action
-    eXosip_lock(context);
-    eXosip_automatic_action(context);
-    eXosip_unlock(context);
-  } while (last_event != nullptr && last_event->type != event_type);
+CallEnd SIPClient::GetEnd() {
+  std::lock_guard<std::mutex> lock(mutex);
+  return end;
+}
 
-  return true;
+int SIPClient::GetCallDuration() {
+  std::lock_guard<std::mutex> lock(mutex);
+  return call_duration;
 }
 
-bool SIPClient::WaitForEvent(eXosip_event_type_t event_type, std::string err_msg) {
-  return WaitForEvent(event_type, err_msg, timeout, 0);
+std::vector<int8_t> SIPClient::TakeCallData() {
+  std::lock_guard<std::mutex> lock(mutex);
+  return std::move(call_data);
 }
 
 int SIPClient::ParseSDPResponse(osip_message_t *response) {
   // Convert the response to a string
   char *buffer = nullptr;
   size_t buf_size = 0;
-  osip_message_to_str(response, &buffer, &buf_size);
+  if (osip_message_to_str(response, &buffer, &buf_size) != 0 || buffer == nullptr) {
+    return -1;
+  }
   std::istringstream msg_stream = std::istringstream(std::string(buffer));
-  delete buffer;
+  osip_free(buffer);
 
   // Iterate over each line and look for m=audio
   std::string curr_line = "";
@@ -341,6 +357,19 @@ int SIPClient::ParseSDPResponse(osip_message_t *response) {
   return -1;
 }
 
+std::string SIPClient::StateToString(CallState state) {
+  switch (state) {
+    case CALL_IDLE: return "Idle";
+    case CALL_INVITING: return "Inviting";
+    case CALL_PROCEEDING: return "Proceeding";
+    case CALL_RINGING: return "Ringing";
+    case CALL_ANSWERED: return "Answered";
+    case CALL_RECORDING: return "Recording";
+    case CALL_TERMINATING: return "Terminating";
+    default: return "Unknown state " + std::to_string(state);
+  }
+}
+
 std::string SIPClient::EventToString(eXosip_event_type event) {
   switch (event) {
     case EXOSIP_REGISTRATION_SUCCESS: return "Registration Success";
@@ -0,0 +1,35 @@
+// Copyright 2020 Barger M., Knoll M., Kofler L.
+#include "spectrogram.hpp"
+
+Spectrogram::Spectrogram(const float *frequencies, int bins) {
+  this->frequencies = frequencies;
+  this->bins = bins;
+}
+
+void Spectrogram::AddFrame(const float *power) {
+  this->power.insert(this->power.end(), power, power + bins);
+}
+
+void Spectrogram::Clear() {
+  power.clear();
+}
+
+size_t Spectrogram::GetFrameCount() const {
+  return power.size() / bins;
+}
+
+int Spectrogram::GetBinCount() const {
+  return bins;
+}
+
+float Spectrogram::GetFrequency(int bin) const {
+  return frequencies[bin];
+}
+
+const float *Spectrogram::GetFrame(size_t frame) const {
+  return power.data() + frame * bins;
+}
+
+float Spectrogram::GetPower(size_t frame, int bin) const {
+  return power[frame * bins + bin];
+}
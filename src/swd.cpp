@@ -13,15 +13,7 @@ int main(int argc, char *argv[]) {
         Wardialer();
         return 0;
       } else if (args->DoAnalyse()) {
-        Wav wav;
-
-        if (wav.Read(args->GetPathToAudio())) {
-          AudioAnalyzer audio_analyzer;
-          audio_analyzer.Analyze(&wav);
-
-          Logger::GetLogger()->Log(audio_analyzer.GetReadableLineType() + " detected in file " + args->GetPathToAudio(),
-              LOG_LVL_STATUS);
-        }
+        return BatchAnalyzer();
       }
   } catch(const char* msg) {
     std::cerr << msg << std::endl;
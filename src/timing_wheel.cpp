@@ -0,0 +1,123 @@
+// Copyright 2020 Barger M., Knoll M., Kofler L.
+
+#include "timing_wheel.hpp"
+
+#include <utility>
+
+// Number of bits of the tick counter used by all levels below a level
+static int LevelShift(int level) {
+  return level == 0 ? 0 : TIMER_ROOT_BITS + (level - 1) * TIMER_LEVEL_BITS;
+}
+
+static uint64_t LevelMask(int level) {
+  return level == 0 ? (1u << TIMER_ROOT_BITS) - 1 : (1u << TIMER_LEVEL_BITS) - 1;
+}
+
+TimingWheel::TimingWheel(int tick_ms) : tick_ms(tick_ms > 0 ? tick_ms : 1), start(std::chrono::steady_clock::now()) {
+  for (int level = 0; level < TIMER_LEVELS; level++) {
+    slots[level].resize(LevelMask(level) + 1);
+  }
+}
+
+TimingWheel::TimerId TimingWheel::Schedule(int delay_ms, Callback callback) {
+  std::lock_guard<std::mutex> lock(mutex);
+  // Round up, a timer never expires early
+  uint64_t ticks = delay_ms > 0 ? (static_cast<uint64_t>(delay_ms) + tick_ms - 1) / tick_ms : 0;
+  TimerId id = next_id++;
+  timers[id] = {current + ticks, callback};
+  Insert(id, current + ticks);
+  return id;
+}
+
+bool TimingWheel::Cancel(TimerId id) {
+  // The id stays in its slot and is skipped when the slot is processed
+  std::lock_guard<std::mutex> lock(mutex);
+  return timers.erase(id) != 0;
+}
+
+void TimingWheel::Advance(std::chrono::steady_clock::time_point now) {
+  uint64_t target = std::chrono::duration_cast<std::chrono::milliseconds>(now - start).count() / tick_ms;
+  uint64_t ticks;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    ticks = target >= current ? target - current + 1 : 0;
+  }
+  Tick(ticks);
+}
+
+void TimingWheel::Tick(uint64_t ticks) {
+  for (uint64_t i = 0; i < ticks; i++) {
+    std::vector<std::pair<TimerId, Callback>> expired;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      // Refill the lower levels from a level whenever all levels below it wrap
+      for (int level = 1; level < TIMER_LEVELS; level++) {
+        if ((current & ((static_cast<uint64_t>(1) << LevelShift(level)) - 1)) != 0) {
+          break;
+        }
+        Cascade(level);
+      }
+
+      std::vector<TimerId> due;
+      due.swap(slots[0][current & LevelMask(0)]);
+      for (TimerId id : due) {
+        auto timer = timers.find(id);
+        if (timer == timers.end()) {
+          continue;
+        }
+        if (timer->second.expiry > current) {
+          Insert(id, timer->second.expiry);
+          continue;
+        }
+        expired.emplace_back(id, std::move(timer->second.callback));
+        timers.erase(timer);
+      }
+      current++;
+    }
+
+    // Callbacks may schedule new timers
+    for (auto &timer : expired) {
+      timer.second(timer.first);
+    }
+  }
+}
+
+size_t TimingWheel::Size() {
+  std::lock_guard<std::mutex> lock(mutex);
+  return timers.size();
+}
+
+int TimingWheel::GetTickMs() const {
+  return tick_ms;
+}
+
+void TimingWheel::Insert(TimerId id, uint64_t expiry) {
+  if (expiry < current) {
+    expiry = current;
+  }
+  uint64_t delta = expiry - current;
+
+  // Timers beyond the range of the wheel wait in the last slot of the
+  // highest level and are inserted again when it is cascaded
+  uint64_t range = static_cast<uint64_t>(1) << LevelShift(TIMER_LEVELS);
+  if (delta >= range) {
+    expiry = current + range - 1;
+  }
+
+  int level = 0;
+  while (delta >= (static_cast<uint64_t>(1) << LevelShift(level + 1)) && level < TIMER_LEVELS - 1) {
+    level++;
+  }
+  slots[level][(expiry >> LevelShift(level)) & LevelMask(level)].push_back(id);
+}
+
+void TimingWheel::Cascade(int level) {
+  std::vector<TimerId> ids;
+  ids.swap(slots[level][(current >> LevelShift(level)) & LevelMask(level)]);
+  for (TimerId id : ids) {
+    auto timer = timers.find(id);
+    if (timer != timers.end()) {
+      Insert(id, timer->second.expiry);
+    }
+  }
+}
@@ -5,16 +5,40 @@ Argparser* args = Argparser::GetArgparser();
 int thread_counter = 0;
 int call_counter = 0;
 std::atomic<int> id_ctr = 0;
-DBClient db = DBClient("wardialing.db");
+// Applies the changes of all threads to the database in grouped transactions
+DBWriter *db = nullptr;
 std::vector<std::thread> calls;
 std::atomic<bool> stop_swd = false;
+// Set if a dial thread gave up because the registration did not come back
+std::atomic<bool> registration_lost = false;
+CallManager *call_manager = nullptr;
+// Analyzes running calls if they are to be terminated early, see -e
+LiveAnalysisPool *live_analysis = nullptr;
+
+// Numbers to wardial. Dial threads take the next number from next_number,
+// numbers of calls which failed because the registration was lost are dialed
+// again first.
+const NumberList &numbers = args->GetNumbers();
+size_t next_number = 0;
+std::deque<CallRecord> redial;
+
+// Calls run on the event thread of the call manager. The dial threads only
+// start them while fewer than max_calls are running.
+std::mutex dial_mutex;              // Guards next_number, redial, in_flight and free_streams
+std::condition_variable dial_cond;  // Signaled when a call has ended
+int max_calls = 0;
+int in_flight = 0;
+// Streams of the live analysis which are not used by a running call
+std::vector<LiveStream *> free_streams;
 
 struct call_data {
-  std::string id;
+  CallRecord record;        // Written as "Call Finished", the analysis completes it
   std::vector<int8_t> alaw_samples;
 };
 
-std::vector<call_data> call_data_vector;
+// Completed calls waiting for analysis. Calls are only started while it has
+// space, so dialing pauses when the analysis threads fall behind.
+BoundedQueue<call_data> analysis_queue(ANALYSIS_QUEUE_CAPACITY);
 
 void signal_handler(int signal) {
   if (stop_swd == false) {
@@ -32,106 +56,265 @@ void segfault_handler(int signal) {
   }
 }
 
-void WardialThread(std::vector<std::string> numbers, int thread_id) {
-  SIPClient *client = new SIPClient(args->GetUsername(), args->GetPassword(), args->GetServer(),
-    4242 + thread_id, thread_id);
-  for ( auto number : numbers ) {
-    std::string id = number + "_" + std::to_string(id_ctr++);
-    db.InsertData(id, number, "Ready", "");
-    if ( client->Register() == true ) {
-      db.UpdateEntry(id, "Calling", "");
-      int call_duration = 0;
-      if ( client->Invite(number, 25000.f, args->GetDebugStatus(), &call_duration) == true ) {
-        call_data data;
-        data.id = id;
-        data.alaw_samples = client->GetCallData();
-        call_data_vector.push_back(data);
-        db.UpdateDuration(id, call_duration);
-        db.UpdateEntry(id, "Call Finished", "");
+// Stores the result of a call and frees its slot. Runs on the event thread
+// of the call manager, or on the dial thread if the call was not started.
+void CallEnded(SIPClient *client, CallRecord record, LiveStream *live, AudioAnalyzer *analyzer) {
+  if (live != nullptr) {
+    live_analysis->Detach(live);
+    SPSCRing<int16_t> *ring = live->GetRing();
+    Logger::GetLogger()->Log("Live analysis ring: maximum fill " + std::to_string(ring->GetMaxFill()) + "/" +
+      std::to_string(ring->GetCapacity()) + ", " + std::to_string(ring->GetOverflow()) + " samples dropped",
+      LOG_LVL_INFO, 0, record.number);
+  }
+
+  bool answered = client->IsAnswered();
+  if (!answered && !call_manager->IsRegistered()) {
+    // The registration is refreshed in the background, the number is dialed
+    // again once it is back
+    Logger::GetLogger()->Log("Registration lost during the call, dialing the number again", LOG_LVL_WARN, 0,
+      record.number);
+    std::lock_guard<std::mutex> lock(dial_mutex);
+    redial.push_back(std::move(record));
+  } else if (answered) {
+    call_data data;
+    data.record = std::move(record);
+    data.record.duration = client->GetCallDuration();
+    data.alaw_samples = client->TakeCallData();
+    if (analyzer != nullptr && data.alaw_samples.size() != 0) {
+      // Already analyzed while the call was running, the record is final
+      analyzer->Finish();
+      data.record.status = STATUS_FINISHED;
+      data.record.dev_type = analyzer->GetLineType();
+      Logger::GetLogger()->Log("Detected device: " + analyzer->GetReadableLineType(), LOG_LVL_STATUS, 0,
+        data.record.number);
+      db->WriteRecord(data.record);
+    } else {
+      // The dial thread waited for space before it started the call, so the
+      // event thread never blocks here
+      data.record.status = STATUS_CALL_FINISHED;
+      db->WriteRecord(data.record);
+      analysis_queue.PushNoWait(std::move(data));
+    }
+  } else {
+    record.status = STATUS_CALL_FAILED;
+    db->WriteRecord(record);
+  }
+  delete analyzer;
+  delete client;
+
+  {
+    std::lock_guard<std::mutex> lock(dial_mutex);
+    if (live != nullptr) {
+      free_streams.push_back(live);
+    }
+    in_flight--;
+  }
+  dial_cond.notify_all();
+}
+
+void StartCall(CallRecord record) {
+  LiveStream *live = nullptr;
+  AudioAnalyzer *analyzer = nullptr;
+  if (live_analysis != nullptr) {
+    {
+      std::lock_guard<std::mutex> lock(dial_mutex);
+      if (!free_streams.empty()) {
+        live = free_streams.back();
+        free_streams.pop_back();
+      }
+    }
+    if (live == nullptr) {
+      live = new LiveStream();
+    }
+    analyzer = new AudioAnalyzer(args->GetEngine());
+    analyzer->SetRetainSpectra(false);
+    live->Reset(analyzer);
+    live_analysis->Attach(live);
+  }
+
+  // The record is only written once the call is over, queued and running
+  // calls are not stored
+  record.start_time = time(nullptr);
+  SIPClient *client = new SIPClient(call_manager);
+  bool started = client->Invite(record.number, MAX_CALL_DURATION_MS, args->GetDebugStatus(), live,
+    [record, live, analyzer](SIPClient *call) { CallEnded(call, record, live, analyzer); });
+  if (!started) {
+    CallEnded(client, std::move(record), live, analyzer);
+  }
+}
+
+void DialThread(int thread_id) {
+  while (true) {
+    // A call is only started if its recording can be queued for analysis
+    // without blocking the event thread
+    analysis_queue.WaitForSpace();
+
+    CallRecord record;
+    {
+      // Wait for a free slot. A running call may still add a number to
+      // redial, so the thread only exits when no call is running.
+      std::unique_lock<std::mutex> lock(dial_mutex);
+      while (!stop_swd && !registration_lost && (in_flight >= max_calls ||
+             (in_flight > 0 && redial.empty() && next_number >= numbers.Size()))) {
+        dial_cond.wait_for(lock, std::chrono::milliseconds(DIAL_WAIT_MS));
+      }
+      if (stop_swd || registration_lost) {
+        break;
+      }
+      if (!redial.empty()) {
+        record = std::move(redial.front());
+        redial.pop_front();
+      } else if (next_number < numbers.Size()) {
+        record = CallRecord(id_ctr++, numbers.At(next_number++));
       } else {
-        db.UpdateEntry(id, "Call Failed", "");
+        break;
       }
-    } else {
-      return;
+      in_flight++;
     }
-    if (stop_swd == true) {
+
+    // The registration is refreshed in the background. While it is lost no
+    // calls are started, the thread gives up if it does not come back.
+    if (!call_manager->WaitForRegistration(stop_swd)) {
+      if (stop_swd == false) {
+        registration_lost = true;
+      }
+      Logger::GetLogger()->Log("Number was not dialed", LOG_LVL_WARN, thread_id, record.number);
+      {
+        std::lock_guard<std::mutex> lock(dial_mutex);
+        in_flight--;
+      }
+      dial_cond.notify_all();
       break;
     }
+    StartCall(std::move(record));
   }
+}
 
-  delete client;
-  return;
+void AnalyzeCallData(call_data *data) {
+  CallRecord &record = data->record;
+  Wav wav;
+  AudioAnalyzer audio_analyzer(args->GetEngine());
+  audio_analyzer.SetRetainSpectra(false);
+  if (wav.Read(data->alaw_samples) != false && audio_analyzer.Analyze(&wav)) {
+    record.status = STATUS_FINISHED;
+    record.dev_type = audio_analyzer.GetLineType();
+    Logger::GetLogger()->Log("Detected device: " + audio_analyzer.GetReadableLineType(), LOG_LVL_STATUS, 0,
+      record.number);
+  } else {
+    record.status = STATUS_ANALYZING_FAILED;
+    Logger::GetLogger()->Log("Analyzing failed", LOG_LVL_STATUS, 0);
+  }
+  db->WriteRecord(record);
 }
 
-void AnalyzeCallData() {
-  for ( auto data : call_data_vector ) {
-    db.UpdateEntry(data.id, "Analyzing", "");
-    Wav wav;
-    AudioAnalyzer audio_analyzer;
-    if (wav.Read(data.alaw_samples) != false) {
-      audio_analyzer.Analyze(&wav);
-      std::string number = data.id.substr(0, data.id.find("_"));
-      Logger::GetLogger()->Log("Detected device: " + audio_analyzer.GetReadableLineType(), LOG_LVL_STATUS, 0, number);
-      db.UpdateEntry(data.id, "Finished", audio_analyzer.GetReadableLineType());
-    } else {
-      Logger::GetLogger()->Log("Analyzing failed", LOG_LVL_STATUS, 0);
-      db.UpdateEntry(data.id, "Analyzing failed", "");
-    }
+void AnalysisThread() {
+  call_data data;
+  while (analysis_queue.Pop(&data)) {
+    Logger::GetLogger()->Log("Analysis queue depth: " + std::to_string(analysis_queue.Size()) + "/" +
+      std::to_string(analysis_queue.GetCapacity()), LOG_LVL_INFO);
+    AnalyzeCallData(&data);
   }
 }
 
 int Wardialer() {
-  std::vector<std::string> numbers = args->GetNumbers();
   std::signal(SIGINT, signal_handler);
   std::signal(SIGHUP, signal_handler);
   std::signal(SIGSEGV, segfault_handler);
-  int max_threads = args->GetThreads();
-
-  // handle case if more threads are specified than numbers
-  if (static_cast<int>(numbers.size()) < max_threads) {
-    max_threads = numbers.size();
-  }
-
-  // caclulate how much numbers should be wardialed by each thread
-  int numbers_per_thread = static_cast<int>(numbers.size()) / max_threads;
-  int numbers_last_thread = numbers_per_thread;
-  if (static_cast<int>(numbers.size()) != (numbers_per_thread * max_threads)) {
-    numbers_last_thread =  numbers.size() - (numbers_per_thread * (max_threads - 1));
-  }
-
-  // split the numbers vector that each thread has the same amount of numbers
-  // to wardial
-  int number_counter;
-  std::vector<std::vector<std::string>> numbers_for_threads;
-  std::vector<std::string>::const_iterator first;
-  std::vector<std::string>::const_iterator last;
-  int gap;
-  for (int i = 0; i < max_threads; i++) {
-    number_counter = i * numbers_per_thread;
-    first = numbers.begin() + number_counter;
-    gap = number_counter + numbers_per_thread;
-    if ( i == max_threads-1 ) {
-      gap = number_counter + numbers_last_thread;
-    }
-    last = numbers.begin() + gap;
-    std::vector<std::string> number_range(first, last);
-    numbers_for_threads.push_back(number_range);
+  max_calls = args->GetThreads();
+
+  // handle case if more calls are allowed than there are numbers
+  if (numbers.Size() < static_cast<size_t>(max_calls)) {
+    max_calls = numbers.Size();
+  }
+
+  db = new DBWriter("wardialing.db", args->GetDBProfile());
+  if (!db->IsOpen()) {
+    Logger::GetLogger()->Log("Can't use the database, no numbers are dialed", LOG_LVL_ERROR);
+    delete db;
+    db = nullptr;
+    return 1;
+  }
+
+  // All calls share one SIP stack
+  call_manager = new CallManager(args->GetUsername(), args->GetPassword(), args->GetServer(), 4242);
+  if (!call_manager->Register()) {
+    delete call_manager;
+    call_manager = nullptr;
+    delete db;
+    db = nullptr;
+    return 1;
+  }
+
+  // Initialize oRTP once before the calls create their sessions
+  RTPRuntime::GetRuntime();
+  if (args->GetRtpEngine()) {
+    RTPRuntime::GetRuntime()->StartEngine();
+  }
+
+  // Analysis threads consume finished calls while dialing continues
+  int analysis_threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+  if (args->GetEarlyHangup()) {
+    live_analysis = new LiveAnalysisPool(analysis_threads);
+  }
+  std::vector<std::thread> analyzers;
+  for (int j = 0; j < analysis_threads; j++) {
+    analyzers.push_back(std::thread(AnalysisThread));
   }
 
-  // Create threads with unique id and their number range
-  int i = 1;
-  for ( std::vector<std::string> number_range : numbers_for_threads ) {
-    calls.push_back(std::thread(WardialThread, number_range, i));
-    i++;
+  // Create threads with unique id which start the calls, all of them share
+  // the numbers
+  int dial_threads = std::min(max_calls, DIAL_THREADS);
+  for (int i = 1; i <= dial_threads; i++) {
+    calls.push_back(std::thread(DialThread, i));
   }
   for (auto & call : calls) {
     if (call.joinable()) {
       call.join();
     }
   }
-  // After all calls are finished analyze the call data
-  if (stop_swd == false) {
-    AnalyzeCallData();
+  {
+    // Let the running calls end
+    std::unique_lock<std::mutex> lock(dial_mutex);
+    dial_cond.wait(lock, [] { return in_flight == 0; });
+  }
+  if (registration_lost) {
+    Logger::GetLogger()->Log("Stopped dialing because the registration was lost", LOG_LVL_ERROR);
+  }
+  for (const CallRecord &record : redial) {
+    Logger::GetLogger()->Log("Number was not dialed", LOG_LVL_WARN, 0, record.number);
   }
-  return 0;
+  if (next_number < numbers.Size()) {
+    Logger::GetLogger()->Log(std::to_string(numbers.Size() - next_number) + " numbers were not dialed, from " +
+      numbers.At(next_number) + " to " + numbers.At(numbers.Size() - 1), LOG_LVL_WARN);
+  }
+  delete call_manager;
+  call_manager = nullptr;
+  RTPRuntime::Shutdown();
+  for (LiveStream *live : free_streams) {
+    delete live;
+  }
+  free_streams.clear();
+  if (live_analysis != nullptr) {
+    Logger::GetLogger()->Log("Live analysis: maximum ring fill " + std::to_string(live_analysis->GetMaxFill()) + "/" +
+      std::to_string(LIVE_RING_SAMPLES) + ", " + std::to_string(live_analysis->GetOverflow()) + " samples dropped",
+      LOG_LVL_INFO);
+    delete live_analysis;
+    live_analysis = nullptr;
+  }
+
+  // Let the analysis threads finish the remaining calls
+  analysis_queue.Close();
+  for (auto & analyzer : analyzers) {
+    analyzer.join();
+  }
+  Logger::GetLogger()->Log("Analysis queue: maximum depth " + std::to_string(analysis_queue.GetMaxSize()) + "/" +
+    std::to_string(analysis_queue.GetCapacity()), LOG_LVL_INFO);
+  db->Flush();
+  Logger::GetLogger()->Log("Database: " + std::to_string(db->GetRowCount()) + " changes in " +
+    std::to_string(db->GetTransactionCount()) + " transactions", LOG_LVL_INFO);
+  LogPlanCacheStats();
+
+  delete db;
+  db = nullptr;
+  return registration_lost ? 1 : 0;
 }
@@ -42,7 +42,7 @@ bool Wav::Read(std::string file_name) {
   return true;
 }
 
-bool Wav::Read(std::vector<int8_t> alaw_samples) {
+bool Wav::Read(const std::vector<int8_t> &alaw_samples) {
   if (alaw_samples.size() == 0) {
     return false;
   }
@@ -65,8 +65,8 @@ void Wav::PrintHeaderInfo() {
   std::cout << "Duration: " << duration << " seconds" << std::endl;
 }
 
-std::vector<int16_t> Wav::GetSamples() {
-  return samples;
+SampleView Wav::GetSamples() const {
+  return SampleView(samples.data(), samples.size());
 }
 
 uint Wav::GetSampleRate() {
@@ -90,31 +90,11 @@ bool Wav::IsWavFile() {
   return false;
 }
 
-void Wav::DecodeAlaw(std::vector<int8_t> alaw_samples) {
-  for (int8_t alaw_sample : alaw_samples) {
-    samples.push_back(DecodeAlawSample(alaw_sample));
-  }
+void Wav::DecodeAlaw(const std::vector<int8_t> &alaw_samples) {
+  samples.resize(alaw_samples.size());
+  ::DecodeAlaw(alaw_samples.data(), alaw_samples.size(), samples.data());
 }
 
 int16_t Wav::DecodeAlawSample(int8_t number) {
-  uint8_t sign = 0x00;
-  uint8_t position = 0;
-  int16_t decoded = 0;
-  number^=0x55;
-
-  if (number & 0x80) {
-    number&=~(1<<7);
-    sign = -1;
-  }
-
-  position = ((number & 0xF0) >> 4) + 4;
-
-  if (position != 4) {
-    decoded = ((1 << position) | ((number & 0x0F) << (position - 4))
-      | (1 << (position - 5)));
-  } else {
-    decoded = (number << 1) | 1;
-  }
-
-  return (sign == 0) ? (decoded) : (-decoded);
+  return alaw_table.values[static_cast<uint8_t>(number)];
 }
@@ -1,6 +1,9 @@
 #include <cxxtest/TestSuite.h>
 #include <wav.hpp>
 #include <audio_analyzer.hpp>
+#include <fft_plan_cache.hpp>
+#include <thread>
+#include <vector>
 
 class AudioAnalyzerTest : public CxxTest::TestSuite {
  public:
@@ -64,4 +67,171 @@ class AudioAnalyzerTest : public CxxTest::TestSuite {
 
     TS_ASSERT_EQUALS(line_type, OTHER);
   }
+
+  void test_streaming_equals_file () {
+    Wav wav;
+    wav.Read("tests/audios/fax.wav");
+
+    AudioAnalyzer file_analyzer;
+    file_analyzer.Analyze(&wav);
+
+    // Feed the audio in chunks of the size of a RTP payload
+    AudioAnalyzer stream_analyzer;
+    SampleView samples = wav.GetSamples();
+    for (size_t idx = 0; idx < samples.size(); idx += 160) {
+      stream_analyzer.Feed(samples.data() + idx, std::min<size_t>(160, samples.size() - idx));
+    }
+    stream_analyzer.Finish();
+
+    TS_ASSERT_EQUALS(stream_analyzer.GetLineType(), file_analyzer.GetLineType());
+    TS_ASSERT_EQUALS(stream_analyzer.GetMaxFrequency(), file_analyzer.GetMaxFrequency());
+  }
+
+  void test_streaming_verdict_modem () {
+    Wav wav;
+    wav.Read("tests/audios/modem2_short.wav");
+
+    AudioAnalyzer audio_analyzer;
+    SampleView samples = wav.GetSamples();
+    size_t idx = 0;
+    while (idx < samples.size() && !audio_analyzer.HasVerdict()) {
+      audio_analyzer.Feed(samples.data() + idx, std::min<size_t>(160, samples.size() - idx));
+      idx += 160;
+    }
+
+    TS_ASSERT(audio_analyzer.HasVerdict());
+    TS_ASSERT_EQUALS(audio_analyzer.GetLineType(), MODEM);
+  }
+
+  void test_streaming_no_verdict_other () {
+    Wav wav;
+    wav.Read("tests/audios/music1.wav");
+
+    AudioAnalyzer audio_analyzer;
+    SampleView samples = wav.GetSamples();
+    audio_analyzer.Feed(samples.data(), samples.size());
+    audio_analyzer.Finish();
+
+    TS_ASSERT(!audio_analyzer.HasVerdict());
+    TS_ASSERT_EQUALS(audio_analyzer.GetLineType(), OTHER);
+  }
+
+  void test_goertzel_modem () {
+    Wav wav;
+    wav.Read("tests/audios/modem1_short.wav");
+
+    AudioAnalyzer audio_analyzer(DetectorEngine::GOERTZEL);
+    audio_analyzer.Analyze(&wav);
+
+    TS_ASSERT_EQUALS(audio_analyzer.GetLineType(), MODEM);
+  }
+
+  void test_goertzel_fax () {
+    Wav wav;
+    wav.Read("tests/audios/fax.wav");
+
+    AudioAnalyzer audio_analyzer(DetectorEngine::GOERTZEL);
+    audio_analyzer.Analyze(&wav);
+
+    TS_ASSERT_EQUALS(audio_analyzer.GetLineType(), FAX);
+  }
+
+  void test_goertzel_other () {
+    Wav wav;
+    wav.Read("tests/audios/music2.wav");
+
+    AudioAnalyzer audio_analyzer(DetectorEngine::GOERTZEL);
+    audio_analyzer.Analyze(&wav);
+
+    TS_ASSERT_EQUALS(audio_analyzer.GetLineType(), OTHER);
+  }
+
+  void test_goertzel_steady_tone () {
+    // Six seconds of the 1100 Hz fax calling tone, the goertzel engine counts
+    // as many peaks for a steady tone as the fft
+    std::vector<int16_t> samples(6 * SAMPLE_RATE);
+    for (size_t i = 0; i < samples.size(); i++) {
+      samples[i] = static_cast<int16_t>(8000 * std::sin(2 * M_PI * 1100 * i / SAMPLE_RATE));
+    }
+
+    AudioAnalyzer fft_analyzer(DetectorEngine::FFT);
+    fft_analyzer.Feed(samples.data(), samples.size());
+    fft_analyzer.Finish();
+    AudioAnalyzer goertzel_analyzer(DetectorEngine::GOERTZEL);
+    goertzel_analyzer.Feed(samples.data(), samples.size());
+    goertzel_analyzer.Finish();
+
+    TS_ASSERT_EQUALS(fft_analyzer.GetLineType(), FAX);
+    TS_ASSERT_EQUALS(goertzel_analyzer.GetLineType(), FAX);
+  }
+
+  void test_plan_cache_reuse () {
+    Wav wav;
+    wav.Read("tests/audios/modem_very_short.wav");
+    FFTPlanCache *cache = FFTPlanCache::GetPlanCache();
+
+    // The first analysis on this thread may compute a plan
+    AudioAnalyzer first_analyzer;
+    first_analyzer.Analyze(&wav);
+    uint64_t misses = cache->GetMisses();
+
+    AudioAnalyzer second_analyzer;
+    second_analyzer.Analyze(&wav);
+    TS_ASSERT_EQUALS(cache->GetMisses(), misses);
+
+    // A plan returned by a finished thread is reused by the next one
+    std::thread([&wav]() { AudioAnalyzer analyzer; analyzer.Analyze(&wav); }).join();
+    misses = cache->GetMisses();
+    uint64_t hits = cache->GetHits();
+    std::thread([&wav]() { AudioAnalyzer analyzer; analyzer.Analyze(&wav); }).join();
+    TS_ASSERT_EQUALS(cache->GetMisses(), misses);
+    TS_ASSERT_EQUALS(cache->GetHits(), hits + 1);
+  }
+
+  void test_spectrum_axis () {
+    for (int i = 0; i < NFREQS; i++) {
+      float frequency = static_cast<float>(i) * (static_cast<float>(SAMPLE_RATE) / 2) / static_cast<float>(NFREQS);
+      int bucket = static_cast<int>(std::round(frequency / 5.0) * 5.0) / 5;
+
+      TS_ASSERT_EQUALS(spectrum_axis.frequency[i], frequency);
+      TS_ASSERT_EQUALS(spectrum_axis.bucket[i], bucket);
+      TS_ASSERT_LESS_THAN(bucket, FCNT_BUCKETS);
+    }
+  }
+
+  void test_peak_count () {
+    Wav wav;
+    wav.Read("tests/audios/modem2_short.wav");
+
+    AudioAnalyzer default_analyzer;
+    default_analyzer.Analyze(&wav);
+
+    // The peak frequency is always the highest peak
+    AudioAnalyzer single_peak_analyzer;
+    single_peak_analyzer.SetPeakCount(1);
+    single_peak_analyzer.Analyze(&wav);
+
+    TS_ASSERT_EQUALS(single_peak_analyzer.GetMaxFrequency(), default_analyzer.GetMaxFrequency());
+  }
+
+  void test_retain_spectra () {
+    Wav wav;
+    wav.Read("tests/audios/modem_very_short.wav");
+    size_t frames = (wav.GetSamples().size() + NFFT - 1) / NFFT;
+
+    AudioAnalyzer audio_analyzer;
+    audio_analyzer.Analyze(&wav);
+    const Spectrogram &spectra = audio_analyzer.GetSpectra();
+
+    TS_ASSERT_EQUALS(spectra.GetFrameCount(), frames);
+    TS_ASSERT_EQUALS(spectra.GetBinCount(), NFREQS);
+    TS_ASSERT_EQUALS(spectra.GetFrequency(NFREQS - 1), spectrum_axis.frequency[NFREQS - 1]);
+
+    AudioAnalyzer classify_analyzer;
+    classify_analyzer.SetRetainSpectra(false);
+    classify_analyzer.Analyze(&wav);
+
+    TS_ASSERT_EQUALS(classify_analyzer.GetSpectra().GetFrameCount(), 0u);
+    TS_ASSERT_EQUALS(classify_analyzer.GetLineType(), audio_analyzer.GetLineType());
+  }
 };
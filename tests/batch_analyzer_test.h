@@ -0,0 +1,121 @@
+#include <cxxtest/TestSuite.h>
+#include <batch_analyzer.hpp>
+#include <wav.hpp>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+class BatchAnalyzerTest : public CxxTest::TestSuite {
+ public:
+  void setUp() {
+    dir = std::filesystem::temp_directory_path() / "swd_batch_analyzer_test";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+  }
+
+  void tearDown() {
+    std::filesystem::remove_all(dir);
+  }
+
+  void test_collect_directory(void) {
+    std::vector<std::string> files = CollectAudioFiles("tests/audios");
+
+    TS_ASSERT_EQUALS(files.size(), 6u);
+    TS_ASSERT_EQUALS(files.front(), "tests/audios/fax.wav");
+    TS_ASSERT_EQUALS(files.back(), "tests/audios/music2.wav");
+    TS_ASSERT(!IsSingleRecording("tests/audios"));
+  }
+
+  void test_collect_pattern(void) {
+    std::vector<std::string> files = CollectAudioFiles("tests/audios/modem*.wav");
+
+    TS_ASSERT_EQUALS(files.size(), 3u);
+    TS_ASSERT_EQUALS(files[0], "tests/audios/modem1_short.wav");
+    TS_ASSERT(!IsSingleRecording("tests/audios/modem*.wav"));
+  }
+
+  void test_collect_list(void) {
+    std::string list = Path("recordings.txt");
+    std::ofstream(list) << "  tests/audios/music1.wav\r\n\n\ttests/audios/fax.wav  \n";
+
+    std::vector<std::string> files = CollectAudioFiles(list);
+    TS_ASSERT_EQUALS(files.size(), 2u);
+    TS_ASSERT_EQUALS(files[0], "tests/audios/fax.wav");
+    TS_ASSERT_EQUALS(files[1], "tests/audios/music1.wav");
+    TS_ASSERT(!IsSingleRecording(list));
+  }
+
+  void test_collect_single(void) {
+    TS_ASSERT(IsSingleRecording("tests/audios/fax.wav"));
+    TS_ASSERT_EQUALS(CollectAudioFiles("tests/audios/fax.wav").size(), 1u);
+
+    // A broken wav file or a binary file is not read as list
+    std::string broken = Path("broken.wav");
+    std::ofstream(broken) << "not a recording\n";
+    TS_ASSERT(IsSingleRecording(broken));
+    std::string binary = Path("recording.raw");
+    std::ofstream(binary, std::ios::binary).write("\x01\x00\x02\x00", 4);
+    TS_ASSERT(IsSingleRecording(binary));
+    TS_ASSERT_EQUALS(CollectAudioFiles(binary).size(), 1u);
+
+    // Missing files are reported when they are read
+    TS_ASSERT(IsSingleRecording(Path("missing.wav")));
+    BatchResult result = AnalyzeAudioFile(Path("missing.wav"), DetectorEngine::FFT);
+    TS_ASSERT_EQUALS(result.status, "Analyzing failed");
+  }
+
+  void test_analyze_file(void) {
+    BatchResult result = AnalyzeAudioFile("tests/audios/fax.wav", DetectorEngine::FFT);
+
+    TS_ASSERT_EQUALS(result.status, "Finished");
+    TS_ASSERT_EQUALS(result.dev_type, "Fax");
+    TS_ASSERT_EQUALS(result.line_type, FAX);
+    TS_ASSERT(result.duration > 0);
+  }
+
+  void test_analyze_wrong_sample_rate(void) {
+    // One second of silence at 16 kHz is read, but must not be classified
+    std::string file = Path("16k.wav");
+    std::vector<int16_t> samples(16000, 0);
+    WAV_HEADER header;
+    memcpy(header.riff_magic_num, "RIFF", 4);
+    header.file_size = sizeof(header) - 8 + samples.size() * 2;
+    memcpy(header.wav_magic_num, "WAVE", 4);
+    memcpy(header.fmt_magic_num, "fmt ", 4);
+    header.fmt_hdr_len = 16;
+    header.format_tag = 1;
+    header.channels = 1;
+    header.sample_rate = 16000;
+    header.bytes_per_second = 32000;
+    header.block_align = 2;
+    header.bits_per_sample = 16;
+    memcpy(header.chunk_magic_num, "data", 4);
+    header.data_block_len = samples.size() * 2;
+    std::ofstream out(file, std::ios::binary);
+    out.write(reinterpret_cast<char *>(&header), sizeof(header));
+    out.write(reinterpret_cast<char *>(samples.data()), samples.size() * 2);
+    out.close();
+
+    BatchResult result = AnalyzeAudioFile(file, DetectorEngine::FFT);
+    TS_ASSERT_EQUALS(result.status, "Analyzing failed");
+    TS_ASSERT_EQUALS(result.dev_type, "");
+    TS_ASSERT_EQUALS(result.line_type, -1);
+  }
+
+  void test_escape_json(void) {
+    TS_ASSERT_EQUALS(EscapeJson("plain/path.wav"), "plain/path.wav");
+    TS_ASSERT_EQUALS(EscapeJson("a\"b\\c"), "a\\\"b\\\\c");
+    TS_ASSERT_EQUALS(EscapeJson("a\nb\rc\td"), "a\\nb\\rc\\td");
+    TS_ASSERT_EQUALS(EscapeJson(std::string("\x01\x1f", 2)), "\\u0001\\u001f");
+    TS_ASSERT_EQUALS(EscapeJson("\xc3\xa4.wav"), "\xc3\xa4.wav");
+  }
+
+ private:
+  std::string Path(const std::string &name) {
+    return (dir / name).string();
+  }
+
+  std::filesystem::path dir;
+};
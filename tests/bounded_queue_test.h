@@ -0,0 +1,112 @@
+#include <cxxtest/TestSuite.h>
+#include <bounded_queue.hpp>
+#include <atomic>
+#include <thread> // NOLINT
+#include <vector>
+
+class BoundedQueueTest : public CxxTest::TestSuite {
+ public:
+  void test_fifo_order(void) {
+    BoundedQueue<int> queue(4);
+    for (int i = 0; i < 4; i++) {
+      TS_ASSERT(queue.Push(i));
+    }
+    TS_ASSERT_EQUALS(queue.Size(), 4u);
+
+    int item = -1;
+    for (int i = 0; i < 4; i++) {
+      TS_ASSERT(queue.Pop(&item));
+      TS_ASSERT_EQUALS(item, i);
+    }
+    TS_ASSERT_EQUALS(queue.GetMaxSize(), 4u);
+  }
+
+  void test_close(void) {
+    BoundedQueue<int> queue(2);
+    queue.Push(1);
+    queue.Close();
+
+    // Queued elements are still delivered, new ones are rejected
+    int item = 0;
+    TS_ASSERT(!queue.Push(2));
+    TS_ASSERT(queue.Pop(&item));
+    TS_ASSERT_EQUALS(item, 1);
+    TS_ASSERT(!queue.Pop(&item));
+  }
+
+  void test_backpressure(void) {
+    BoundedQueue<int> queue(2);
+    std::atomic<int> consumed = 0;
+    std::atomic<int> sum = 0;
+
+    std::vector<std::thread> consumers;
+    for (int i = 0; i < 3; i++) {
+      consumers.push_back(std::thread([&] {
+        int item;
+        while (queue.Pop(&item)) {
+          sum += item;
+          consumed++;
+        }
+      }));
+    }
+    for (int i = 1; i <= 1000; i++) {
+      queue.Push(i);
+    }
+    queue.Close();
+    for (auto &consumer : consumers) {
+      consumer.join();
+    }
+
+    TS_ASSERT_EQUALS(consumed, 1000);
+    TS_ASSERT_EQUALS(sum, 500500);
+    TS_ASSERT(queue.GetMaxSize() <= 2u);
+  }
+
+  void test_push_no_wait(void) {
+    BoundedQueue<int> queue(1);
+    TS_ASSERT(queue.PushNoWait(1));
+    TS_ASSERT(queue.PushNoWait(2));
+    TS_ASSERT_EQUALS(queue.Size(), 2u);
+    TS_ASSERT_EQUALS(queue.GetMaxSize(), 2u);
+
+    int item = 0;
+    TS_ASSERT(queue.Pop(&item));
+    TS_ASSERT_EQUALS(item, 1);
+    queue.Close();
+    TS_ASSERT(!queue.PushNoWait(3));
+    TS_ASSERT(queue.Pop(&item));
+    TS_ASSERT_EQUALS(item, 2);
+  }
+
+  void test_wait_for_space(void) {
+    BoundedQueue<int> queue(1);
+    queue.Push(1);
+    std::atomic<int> waiting = 0;
+
+    // Both waiters are released by a single pop
+    std::vector<std::thread> waiters;
+    for (int i = 0; i < 2; i++) {
+      waiters.push_back(std::thread([&] {
+        waiting++;
+        TS_ASSERT(queue.WaitForSpace());
+        waiting--;
+      }));
+    }
+    while (waiting < 2) {
+      std::this_thread::yield();
+    }
+    int item = 0;
+    TS_ASSERT(queue.Pop(&item));
+    for (auto &waiter : waiters) {
+      waiter.join();
+    }
+    TS_ASSERT_EQUALS(waiting, 0);
+    TS_ASSERT_EQUALS(queue.Size(), 0u);
+
+    // A closed queue stops the wait
+    queue.Push(2);
+    std::thread closed([&] { TS_ASSERT(!queue.WaitForSpace()); });
+    queue.Close();
+    closed.join();
+  }
+};
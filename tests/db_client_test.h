@@ -0,0 +1,227 @@
+#include <cxxtest/TestSuite.h>
+#include <db_client.hpp>
+#include <db_writer.hpp>
+#include <sqlite3.h>
+#include <filesystem>
+#include <string>
+
+class DBClientTest : public CxxTest::TestSuite {
+ public:
+  void setUp() {
+    dir = std::filesystem::temp_directory_path() / "swd_db_client_test";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    path = (dir / "wardialing.db").string();
+  }
+
+  void tearDown() {
+    std::filesystem::remove_all(dir);
+  }
+
+  void test_split_number(void) {
+    int64_t value = -1;
+    int leading_zeros = -1;
+
+    TS_ASSERT(SplitNumber("0043123", &value, &leading_zeros));
+    TS_ASSERT_EQUALS(value, 43123);
+    TS_ASSERT_EQUALS(leading_zeros, 2);
+    TS_ASSERT(SplitNumber("+43999", &value, &leading_zeros));
+    TS_ASSERT_EQUALS(value, 43999);
+    TS_ASSERT_EQUALS(leading_zeros, 0);
+    TS_ASSERT(SplitNumber("+0043", &value, &leading_zeros));
+    TS_ASSERT_EQUALS(value, 43);
+    TS_ASSERT_EQUALS(leading_zeros, 2);
+
+    // At least one digit is kept as value
+    TS_ASSERT(SplitNumber("0", &value, &leading_zeros));
+    TS_ASSERT_EQUALS(value, 0);
+    TS_ASSERT_EQUALS(leading_zeros, 0);
+    TS_ASSERT(SplitNumber("000", &value, &leading_zeros));
+    TS_ASSERT_EQUALS(value, 0);
+    TS_ASSERT_EQUALS(leading_zeros, 2);
+
+    // 18 digits fit into the value, more are stored as text
+    TS_ASSERT(SplitNumber("0999999999999999999", &value, &leading_zeros));
+    TS_ASSERT_EQUALS(value, 999999999999999999);
+    TS_ASSERT_EQUALS(leading_zeros, 1);
+    TS_ASSERT(!SplitNumber("1000000000000000000", &value, &leading_zeros));
+    TS_ASSERT(!SplitNumber("00000000000000000001", &value, &leading_zeros));
+
+    TS_ASSERT(!SplitNumber("", &value, &leading_zeros));
+    TS_ASSERT(!SplitNumber("+", &value, &leading_zeros));
+    TS_ASSERT(!SplitNumber("*31#12", &value, &leading_zeros));
+    TS_ASSERT(!SplitNumber("0664 123", &value, &leading_zeros));
+    TS_ASSERT(!SplitNumber("43+1", &value, &leading_zeros));
+  }
+
+  void test_calls_readable(void) {
+    {
+      DBClient client(path);
+      TS_ASSERT(client.IsOpen());
+
+      CallRecord record(1, "0043123");
+      record.start_time = 1588327200;
+      record.status = STATUS_CALL_FINISHED;
+      TS_ASSERT(client.WriteRecord(record));
+      record.status = STATUS_FINISHED;
+      record.duration = 12;
+      record.dev_type = 1;
+      TS_ASSERT(client.WriteRecord(record));
+
+      CallRecord text(2, "*31#12");
+      text.start_time = 1588327260;
+      text.status = STATUS_CALL_FAILED;
+      TS_ASSERT(client.WriteRecord(text));
+    }
+
+    TS_ASSERT_EQUALS(Query("select count(*) from calls;"), "2");
+    TS_ASSERT_EQUALS(Query("select number || '|' || leading_zeros from calls where seq = 1;"), "43123|2");
+    TS_ASSERT_EQUALS(Query("select number || '|' || start_time || '|' || duration || '|' || status || '|' || dev_type"
+      " from calls_readable where seq = 1;"), "0043123|2020-05-01 10:00:00|12|Finished|Modem");
+    TS_ASSERT_EQUALS(Query("select number || '|' || status || '|' || coalesce(dev_type, 'null')"
+      " from calls_readable where seq = 2;"), "*31#12|Call Failed|null");
+  }
+
+  void test_migrate_v1(void) {
+    Execute(
+      "create table calls("
+      "  id text primary key not null,"
+      "  number text not null,"
+      "  start_time text not null,"
+      "  duration integer,"
+      "  status text not null,"
+      "  dev_type text"
+      ");"
+      "insert into calls values"
+      "  ('0664123_1', '0664123', '2020-05-01 10:00:00', 12, 'Finished', 'Fax'),"
+      "  ('+43999_2', '+43999', '2020-05-01 10:01:00', null, 'Call failed', null),"
+      "  ('*31#_3', '*31#', '2020-05-01 10:02:00', null, 'Calling', null),"
+      "  ('0664777_4', '0664777', '2020-05-01 10:03:00', null, 'Busy', null),"
+      "  ('/rec/a.wav', '/rec/a.wav', '2020-05-02 08:00:00', 20, 'Finished', 'Modem');");
+
+    {
+      DBClient client(path);
+      TS_ASSERT(client.IsOpen());
+    }
+
+    TS_ASSERT_EQUALS(Query("pragma user_version;"), std::to_string(DB_SCHEMA_VERSION));
+    TS_ASSERT_EQUALS(Query("select count(*) from sqlite_master where name = 'calls_v1';"), "0");
+    TS_ASSERT_EQUALS(Query("select count(*) from campaigns;"), "1");
+    TS_ASSERT_EQUALS(Query("select count(*) from calls;"), "4");
+    TS_ASSERT_EQUALS(Query("select count(*) from recordings;"), "1");
+
+    TS_ASSERT_EQUALS(Query("select number || '|' || leading_zeros || '|' || duration || '|' || status || '|' || dev_type"
+      " from calls where seq = 1;"), "664123|1|12|5|0");
+    TS_ASSERT_EQUALS(Query("select number || '|' || start_time || '|' || status"
+      " from calls_readable where seq = 2;"), "43999|2020-05-01 10:01:00|Call Failed");
+    TS_ASSERT_EQUALS(Query("select typeof(number) || '|' || number from calls where seq = 3;"), "text|*31#");
+
+    // A status without a code does not stop the migration
+    TS_ASSERT_EQUALS(Query("select status from calls where seq = 4;"), std::to_string(STATUS_UNKNOWN));
+    TS_ASSERT_EQUALS(Query("select status from calls_readable where seq = 4;"), "Unknown");
+
+    TS_ASSERT_EQUALS(Query("select path || '|' || duration || '|' || status || '|' || dev_type"
+      " from recordings_readable;"), "/rec/a.wav|20|Finished|Modem");
+
+    // Opening the migrated database again keeps it as it is
+    {
+      DBClient client(path);
+      TS_ASSERT(client.IsOpen());
+    }
+    TS_ASSERT_EQUALS(Query("select count(*) from calls;"), "4");
+  }
+
+  void test_migrate_v2(void) {
+    // Version 2 has no analysis time of the recordings
+    Execute(
+      "create table recordings("
+      "  id integer primary key,"
+      "  path text not null unique,"
+      "  start_time integer not null,"
+      "  duration integer,"
+      "  status integer not null,"
+      "  dev_type integer"
+      ");"
+      "create view recordings_readable as select id, path from recordings;"
+      "insert into recordings values (1, '/rec/a.wav', 1588327200, 20, 5, 1);"
+      "pragma user_version = 2;");
+
+    {
+      DBClient client(path);
+      TS_ASSERT(client.IsOpen());
+      TS_ASSERT(client.WriteRecording("/rec/b.wav", STATUS_FINISHED, 0, 3, 4.5));
+    }
+
+    TS_ASSERT_EQUALS(Query("pragma user_version;"), std::to_string(DB_SCHEMA_VERSION));
+    TS_ASSERT_EQUALS(Query("select coalesce(analysis_ms, 'null') from recordings_readable where path = '/rec/a.wav';"),
+      "null");
+    TS_ASSERT_EQUALS(Query("select dev_type || '|' || analysis_ms from recordings_readable where path = '/rec/b.wav';"),
+      "Fax|4.5");
+  }
+
+  void test_profiles(void) {
+    // synchronous is 1 for NORMAL and 2 for FULL
+    CheckProfile("fast", "wal", "1", "-16384");
+    CheckProfile("safe", "wal", "2", "-2000");
+    CheckProfile("compat", "delete", "2", "-2000");
+
+    DBProfile profile;
+    TS_ASSERT(!DBProfile::FromName("turbo", &profile));
+    TS_ASSERT(!DBProfile::FromName("", &profile));
+    TS_ASSERT(!DBProfile::FromName("FAST", &profile));
+  }
+
+  void test_unknown_schema_version(void) {
+    Execute("create table calls(id integer primary key); pragma user_version = " +
+      std::to_string(DB_SCHEMA_VERSION + 1) + ";");
+
+    DBClient client(path);
+    TS_ASSERT(!client.IsOpen());
+    DBWriter writer(path);
+    TS_ASSERT(!writer.IsOpen());
+    TS_ASSERT_EQUALS(Query("pragma user_version;"), std::to_string(DB_SCHEMA_VERSION + 1));
+  }
+
+ private:
+  // Opens a database with a named profile and checks the settings of the
+  // connection
+  void CheckProfile(const std::string &name, const std::string &journal_mode, const std::string &synchronous,
+                    const std::string &cache_size) {
+    DBProfile profile;
+    TS_ASSERT(DBProfile::FromName(name, &profile));
+    DBClient client((dir / (name + ".db")).string(), profile);
+    TS_ASSERT(client.IsOpen());
+
+    TS_ASSERT_EQUALS(client.GetPragma("journal_mode"), journal_mode);
+    TS_ASSERT_EQUALS(client.GetPragma("synchronous"), synchronous);
+    TS_ASSERT_EQUALS(client.GetPragma("cache_size"), cache_size);
+    TS_ASSERT_EQUALS(client.GetPragma("busy_timeout"), std::to_string(profile.busy_timeout));
+  }
+
+  // Runs statements on a separate connection
+  void Execute(const std::string &cmd) {
+    sqlite3 *db = nullptr;
+    sqlite3_open(path.c_str(), &db);
+    TS_ASSERT_EQUALS(sqlite3_exec(db, cmd.c_str(), nullptr, nullptr, nullptr), SQLITE_OK);
+    sqlite3_close(db);
+  }
+
+  // Runs a query on a separate connection and returns the first column of
+  // the first row, empty if there is none
+  std::string Query(const std::string &cmd) {
+    sqlite3 *db = nullptr;
+    sqlite3_stmt *stmt = nullptr;
+    std::string value;
+    sqlite3_open(path.c_str(), &db);
+    if (sqlite3_prepare_v2(db, cmd.c_str(), -1, &stmt, nullptr) == SQLITE_OK && sqlite3_step(stmt) == SQLITE_ROW &&
+        sqlite3_column_text(stmt, 0) != nullptr) {
+      value = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0));
+    }
+    sqlite3_finalize(stmt);
+    sqlite3_close(db);
+    return value;
+  }
+
+  std::filesystem::path dir;
+  std::string path;
+};
@@ -0,0 +1,173 @@
+#include <cxxtest/TestSuite.h>
+#include <db_writer.hpp>
+#include <sqlite3.h>
+#include <chrono> // NOLINT
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <thread> // NOLINT
+#include <vector>
+
+class DBWriterTest : public CxxTest::TestSuite {
+ public:
+  void setUp() {
+    dir = std::filesystem::temp_directory_path() / "swd_db_writer_test";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    path = (dir / "wardialing.db").string();
+  }
+
+  void tearDown() {
+    std::filesystem::remove_all(dir);
+  }
+
+  void test_concurrent_posters(void) {
+    const int threads = 4;
+    const int calls = 500;
+    DBWriter writer(path, DBProfile(), 10, 64);
+
+    std::vector<std::thread> posters;
+    for (int t = 0; t < threads; t++) {
+      posters.emplace_back([&writer, t]() {
+        for (int i = 0; i < calls; i++) {
+          CallRecord record(t * calls + i, "0664" + std::to_string(t * calls + i));
+          record.status = STATUS_CALLING;
+          writer.WriteRecord(record);
+          record.status = STATUS_CALL_FINISHED;
+          writer.WriteRecord(record);
+        }
+      });
+    }
+    for (std::thread &poster : posters) {
+      poster.join();
+    }
+    writer.Flush();
+
+    TS_ASSERT_EQUALS(writer.GetRowCount(), 2u * threads * calls);
+    TS_ASSERT_LESS_THAN(writer.GetTransactionCount(), 2u * threads * calls);
+    TS_ASSERT_EQUALS(Query("select count(*) from calls;"), threads * calls);
+    TS_ASSERT_EQUALS(Query("select count(*) from calls where status = 2;"), threads * calls);
+  }
+
+  void test_flush_order(void) {
+    // Flush() must not wait for the interval
+    DBWriter writer(path, DBProfile(), 60000, 1000);
+
+    CallRecord record(1, "06641234");
+    record.status = STATUS_CALLING;
+    writer.WriteRecord(record);
+    record.status = STATUS_CALL_FINISHED;
+    record.duration = 12;
+    writer.WriteRecord(record);
+    writer.WriteRecording("fax.wav", STATUS_ANALYZING_FAILED, -1, 0, 1.5);
+    writer.WriteRecording("fax.wav", STATUS_FINISHED, FAX_DEVICE, 3, 12.25);
+    writer.Flush();
+
+    // The change posted last wins
+    TS_ASSERT_EQUALS(Query("select status from calls where seq = 1;"), STATUS_CALL_FINISHED);
+    TS_ASSERT_EQUALS(Query("select duration from calls where seq = 1;"), 12);
+    TS_ASSERT_EQUALS(Query("select status from recordings where path = 'fax.wav';"), STATUS_FINISHED);
+    TS_ASSERT_EQUALS(Query("select analysis_ms * 100 from recordings where path = 'fax.wav';"), 1225);
+    TS_ASSERT_EQUALS(writer.GetRowCount(), 4u);
+    TS_ASSERT_EQUALS(writer.GetTransactionCount(), 1u);
+
+    // A second flush without new changes returns at once
+    writer.Flush();
+    TS_ASSERT_EQUALS(writer.GetTransactionCount(), 1u);
+  }
+
+  void test_destructor_drains_queue(void) {
+    {
+      DBWriter writer(path, DBProfile(), 60000, 1000);
+      for (int i = 0; i < 100; i++) {
+        writer.WriteRecord(CallRecord(i, std::to_string(i)));
+      }
+    }
+
+    TS_ASSERT_EQUALS(Query("select count(*) from calls;"), 100);
+  }
+
+  void test_locked_database_is_retried(void) {
+    DBProfile profile;
+    profile.busy_timeout = 300;
+    DBWriter writer(path, profile, 10, 1000);
+    writer.Flush();
+
+    // The first transaction can't get the write lock, the batch is tried
+    // again after the lock has been released
+    sqlite3 *lock = Lock();
+    for (int i = 0; i < 100; i++) {
+      writer.WriteRecord(CallRecord(i, std::to_string(i)));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(400));
+    Unlock(lock);
+    writer.Flush();
+
+    TS_ASSERT_EQUALS(writer.GetRowCount(), 100u);
+    TS_ASSERT_EQUALS(writer.GetTransactionCount(), 1u);
+    TS_ASSERT_EQUALS(Query("select count(*) from calls;"), 100);
+  }
+
+  void test_locked_database_drops_batch(void) {
+    DBProfile profile;
+    profile.busy_timeout = 50;
+    DBWriter writer(path, profile, 10, 1000);
+    writer.Flush();
+
+    // The lock is waited for once per transaction, not once per change
+    sqlite3 *lock = Lock();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 100; i++) {
+      writer.WriteRecord(CallRecord(i, std::to_string(i)));
+    }
+    writer.WriteRecording("fax.wav", STATUS_FINISHED, FAX_DEVICE, 3, 12.25);
+    writer.Flush();
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    TS_ASSERT_LESS_THAN(elapsed.count(), 2000);
+    TS_ASSERT_EQUALS(writer.GetRowCount(), 0u);
+    TS_ASSERT_EQUALS(writer.GetTransactionCount(), 0u);
+
+    // The writer goes on once the lock is released
+    Unlock(lock);
+    writer.WriteRecord(CallRecord(100, "100"));
+    writer.Flush();
+    TS_ASSERT_EQUALS(writer.GetRowCount(), 1u);
+    TS_ASSERT_EQUALS(Query("select count(*) from calls;"), 1);
+    TS_ASSERT_EQUALS(Query("select count(*) from campaigns;"), 1);
+  }
+
+ private:
+  static const int FAX_DEVICE = 0;
+
+  // Takes the write lock on a separate connection
+  sqlite3 *Lock() {
+    sqlite3 *db = nullptr;
+    sqlite3_open(path.c_str(), &db);
+    TS_ASSERT_EQUALS(sqlite3_exec(db, "begin immediate;", nullptr, nullptr, nullptr), SQLITE_OK);
+    return db;
+  }
+
+  // Releases the lock taken by Lock()
+  void Unlock(sqlite3 *db) {
+    sqlite3_exec(db, "rollback;", nullptr, nullptr, nullptr);
+    sqlite3_close(db);
+  }
+
+  // Runs a query on a separate connection and returns the first column of
+  // the first row, -1 if there is none
+  int64_t Query(const std::string &cmd) {
+    sqlite3 *db = nullptr;
+    sqlite3_stmt *stmt = nullptr;
+    int64_t value = -1;
+    sqlite3_open(path.c_str(), &db);
+    if (sqlite3_prepare_v2(db, cmd.c_str(), -1, &stmt, nullptr) == SQLITE_OK && sqlite3_step(stmt) == SQLITE_ROW) {
+      value = sqlite3_column_int64(stmt, 0);
+    }
+    sqlite3_finalize(stmt);
+    sqlite3_close(db);
+    return value;
+  }
+
+  std::filesystem::path dir;
+  std::string path;
+};
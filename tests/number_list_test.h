@@ -0,0 +1,36 @@
+#include <cxxtest/TestSuite.h>
+#include <number_list.hpp>
+#include <string>
+
+class NumberListTest : public CxxTest::TestSuite {
+ public:
+  void test_numbers_and_ranges(void) {
+    NumberList numbers;
+    numbers.AddNumber("220");
+    numbers.AddRange(98, 101, 4);
+    numbers.AddNumber("+43123");
+
+    TS_ASSERT_EQUALS(numbers.Size(), 6u);
+    TS_ASSERT_EQUALS(numbers.At(0), "220");
+    TS_ASSERT_EQUALS(numbers.At(1), "0098");
+    TS_ASSERT_EQUALS(numbers.At(2), "0099");
+    TS_ASSERT_EQUALS(numbers.At(3), "0100");
+    TS_ASSERT_EQUALS(numbers.At(4), "0101");
+    TS_ASSERT_EQUALS(numbers.At(5), "+43123");
+  }
+
+  void test_large_range(void) {
+    NumberList numbers;
+    numbers.AddRange(10000000, 99999999, 8);
+
+    TS_ASSERT_EQUALS(numbers.Size(), 90000000u);
+    TS_ASSERT_EQUALS(numbers.At(0), "10000000");
+    TS_ASSERT_EQUALS(numbers.At(89999999), "99999999");
+  }
+
+  void test_empty(void) {
+    NumberList numbers;
+    TS_ASSERT(numbers.Empty());
+    TS_ASSERT_EQUALS(numbers.Size(), 0u);
+  }
+};
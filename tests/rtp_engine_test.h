@@ -0,0 +1,120 @@
+#include <cxxtest/TestSuite.h>
+#include <rtp_engine.hpp>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <chrono> // NOLINT
+#include <cstring>
+#include <thread> // NOLINT
+#include <vector>
+
+class RTPEngineTest : public CxxTest::TestSuite {
+ public:
+  // Sends an RTP packet with 160 bytes of payload to a local port
+  void SendPacket(int fd, int port, uint8_t payload_type, uint16_t seq, uint32_t ssrc) {
+    uint8_t packet[12 + 160];
+    memset(packet, 0x55, sizeof(packet));
+    packet[0] = 0x80;
+    packet[1] = payload_type;
+    packet[2] = seq >> 8;
+    packet[3] = seq & 0xff;
+    packet[8] = ssrc >> 24;
+    packet[9] = (ssrc >> 16) & 0xff;
+    packet[10] = (ssrc >> 8) & 0xff;
+    packet[11] = ssrc & 0xff;
+    SendRaw(fd, port, packet, sizeof(packet));
+  }
+
+  void SendRaw(int fd, int port, const uint8_t *data, size_t len) {
+    sockaddr_in target;
+    memset(&target, 0, sizeof(target));
+    target.sin_family = AF_INET;
+    target.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    target.sin_port = htons(port);
+    sendto(fd, data, len, 0, reinterpret_cast<sockaddr *>(&target), sizeof(target));
+  }
+
+  // Waits until the stream has seen the given number of packets
+  RTPStreamStats WaitForPackets(RTPStream *stream, uint64_t count) {
+    RTPStreamStats stats;
+    for (int i = 0; i < 200; i++) {
+      stats = stream->GetStats();
+      if (stats.packets + stats.dropped >= count) {
+        break;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return stats;
+  }
+
+  void test_demultiplex(void) {
+    RTPEngine engine;
+    RTPStream *first = engine.Open(8);
+    RTPStream *second = engine.Open(8);
+    TS_ASSERT(first != nullptr && second != nullptr);
+    TS_ASSERT_DIFFERS(first->GetLocalPort(), second->GetLocalPort());
+    TS_ASSERT_EQUALS(engine.GetStreamCount(), 2u);
+
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    SendPacket(fd, first->GetLocalPort(), 8, 10, 1);
+    SendPacket(fd, first->GetLocalPort(), 8, 11, 1);
+    SendPacket(fd, second->GetLocalPort(), 8, 500, 2);
+
+    TS_ASSERT_EQUALS(WaitForPackets(first, 2).packets, 2u);
+    TS_ASSERT_EQUALS(WaitForPackets(second, 1).packets, 1u);
+
+    std::vector<int8_t> data;
+    TS_ASSERT_EQUALS(first->Take(&data), 320u);
+    TS_ASSERT_EQUALS(first->Take(&data), 0u);
+    TS_ASSERT_EQUALS(second->Take(&data), 160u);
+    TS_ASSERT_EQUALS(data.size(), 480u);
+    TS_ASSERT_EQUALS(data[0], 0x55);
+
+    engine.Close(first);
+    engine.Close(second);
+    TS_ASSERT_EQUALS(engine.GetStreamCount(), 0u);
+    close(fd);
+  }
+
+  void test_counters(void) {
+    RTPEngine engine;
+    RTPStream *stream = engine.Open(8);
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    uint8_t garbage[4] = {0x80, 8, 0, 0};
+
+    SendPacket(fd, stream->GetLocalPort(), 8, 0, 7);
+    SendPacket(fd, stream->GetLocalPort(), 8, 3, 7);   // 1 and 2 are lost
+    SendPacket(fd, stream->GetLocalPort(), 8, 4, 9);   // foreign SSRC
+    SendPacket(fd, stream->GetLocalPort(), 13, 4, 7);  // comfort noise
+    SendRaw(fd, stream->GetLocalPort(), garbage, sizeof(garbage));
+    SendPacket(fd, stream->GetLocalPort(), 8, 2, 7);   // late packet
+
+    RTPStreamStats stats = WaitForPackets(stream, 6);
+    TS_ASSERT_EQUALS(stats.packets, 3u);
+    TS_ASSERT_EQUALS(stats.bytes, 480u);
+    TS_ASSERT_EQUALS(stats.lost, 1u);
+    TS_ASSERT_EQUALS(stats.dropped, 3u);
+    close(fd);
+  }
+
+  void test_connect(void) {
+    RTPEngine engine;
+    RTPStream *stream = engine.Open(8);
+
+    // The remote side receives the empty initial packet
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in local;
+    memset(&local, 0, sizeof(local));
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(local);
+    bind(fd, reinterpret_cast<sockaddr *>(&local), sizeof(local));
+    getsockname(fd, reinterpret_cast<sockaddr *>(&local), &len);
+
+    TS_ASSERT(engine.Connect(stream, "127.0.0.1", ntohs(local.sin_port)));
+    uint8_t packet[64];
+    TS_ASSERT_EQUALS(recv(fd, packet, sizeof(packet), 0), 12);
+    TS_ASSERT_EQUALS(packet[0], 0x80);
+    TS_ASSERT_EQUALS(packet[1], 8);
+    close(fd);
+  }
+};
@@ -0,0 +1,100 @@
+#include <cxxtest/TestSuite.h>
+#include <spsc_ring.hpp>
+#include <live_analysis.hpp>
+#include <thread> // NOLINT
+#include <vector>
+
+class SPSCRingTest : public CxxTest::TestSuite {
+ public:
+  void test_wrap_around(void) {
+    SPSCRing<int> ring(6);
+    TS_ASSERT_EQUALS(ring.GetCapacity(), 8u);
+
+    int out[8];
+    int value = 0;
+    int expected = 0;
+    // Write and read in steps which do not divide the capacity
+    for (int round = 0; round < 10; round++) {
+      int in[5];
+      for (int i = 0; i < 5; i++) {
+        in[i] = value++;
+      }
+      TS_ASSERT_EQUALS(ring.Write(in, 5), 5u);
+      TS_ASSERT_EQUALS(ring.Read(out, 8), 5u);
+      for (int i = 0; i < 5; i++) {
+        TS_ASSERT_EQUALS(out[i], expected++);
+      }
+    }
+    TS_ASSERT_EQUALS(ring.Size(), 0u);
+    TS_ASSERT_EQUALS(ring.GetOverflow(), 0u);
+  }
+
+  void test_overflow(void) {
+    SPSCRing<int> ring(4);
+    int in[6] = {1, 2, 3, 4, 5, 6};
+    TS_ASSERT_EQUALS(ring.Write(in, 6), 4u);
+    TS_ASSERT_EQUALS(ring.GetOverflow(), 2u);
+    TS_ASSERT_EQUALS(ring.GetMaxFill(), 4u);
+
+    int out[4];
+    TS_ASSERT_EQUALS(ring.Read(out, 4), 4u);
+    TS_ASSERT_EQUALS(out[3], 4);
+
+    ring.Reset();
+    TS_ASSERT_EQUALS(ring.GetOverflow(), 0u);
+    TS_ASSERT_EQUALS(ring.GetMaxFill(), 0u);
+  }
+
+  void test_concurrent(void) {
+    SPSCRing<int> ring(64);
+    const int count = 100000;
+    long long sum = 0;
+    bool ordered = true;
+
+    std::thread consumer([&] {
+      int out[16];
+      int received = 0;
+      int expected = 0;
+      while (received < count) {
+        size_t n = ring.Read(out, 16);
+        for (size_t i = 0; i < n; i++) {
+          // Order is kept
+          if (out[i] != expected++) {
+            ordered = false;
+          }
+          sum += out[i];
+        }
+        received += n;
+      }
+    });
+
+    // Retry until everything fits, so nothing is dropped
+    for (int i = 0; i < count;) {
+      if (ring.Write(&i, 1) == 1) {
+        i++;
+      }
+    }
+    consumer.join();
+    TS_ASSERT(ordered);
+    TS_ASSERT_EQUALS(sum, static_cast<long long>(count) * (count - 1) / 2);
+    TS_ASSERT(ring.GetMaxFill() <= 64u);
+  }
+
+  void test_live_pool(void) {
+    LiveAnalysisPool pool(2);
+    AudioAnalyzer analyzer;
+    LiveStream stream;
+    stream.Reset(&analyzer);
+    pool.Attach(&stream);
+
+    // One second of silence, the worker or Detach() feeds it into the analyzer
+    std::vector<int16_t> samples(8000, 0);
+    TS_ASSERT_EQUALS(stream.GetRing()->Write(samples.data(), samples.size()), samples.size());
+    pool.Detach(&stream);
+
+    TS_ASSERT_EQUALS(stream.GetRing()->Size(), 0u);
+    TS_ASSERT(!stream.HasVerdict());
+    TS_ASSERT_EQUALS(pool.GetMaxFill(), 8000u);
+    TS_ASSERT_EQUALS(pool.GetOverflow(), 0u);
+  }
+};
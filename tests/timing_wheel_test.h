@@ -0,0 +1,62 @@
+#include <cxxtest/TestSuite.h>
+#include <timing_wheel.hpp>
+#include <vector>
+
+class TimingWheelTest : public CxxTest::TestSuite {
+ public:
+  void test_expiry(void) {
+    TimingWheel wheel(10);
+    int fired = 0;
+    wheel.Schedule(25, [&](TimingWheel::TimerId) { fired++; });
+
+    // 25 ms round up to 3 ticks, the timer runs when tick 3 is processed
+    wheel.Tick(3);
+    TS_ASSERT_EQUALS(fired, 0);
+    wheel.Tick(1);
+    TS_ASSERT_EQUALS(fired, 1);
+    TS_ASSERT_EQUALS(wheel.Size(), 0u);
+  }
+
+  void test_cancel(void) {
+    TimingWheel wheel(1);
+    int fired = 0;
+    TimingWheel::TimerId id = wheel.Schedule(5, [&](TimingWheel::TimerId) { fired++; });
+
+    TS_ASSERT(wheel.Cancel(id));
+    TS_ASSERT(!wheel.Cancel(id));
+    wheel.Tick(10);
+    TS_ASSERT_EQUALS(fired, 0);
+  }
+
+  void test_all_levels(void) {
+    // Delays in every level, including the borders between the levels
+    std::vector<int> delays = {0, 1, 255, 256, 257, 1000, 16383, 16384, 16385, 100000, 1048575, 1048576, 1500000};
+    std::vector<int64_t> fired(delays.size(), -1);
+    int64_t now = 0;
+
+    TimingWheel wheel(1);
+    wheel.Tick(77);   // Start unaligned
+    for (size_t i = 0; i < delays.size(); i++) {
+      wheel.Schedule(delays[i], [&fired, &now, i](TimingWheel::TimerId) { fired[i] = now; });
+    }
+    for (now = 0; now <= 1500000; now++) {
+      wheel.Tick(1);
+    }
+
+    for (size_t i = 0; i < delays.size(); i++) {
+      TS_ASSERT_EQUALS(fired[i], delays[i]);
+    }
+  }
+
+  void test_schedule_from_callback(void) {
+    TimingWheel wheel(1);
+    int fired = 0;
+    wheel.Schedule(1, [&](TimingWheel::TimerId) {
+      fired++;
+      wheel.Schedule(1, [&](TimingWheel::TimerId) { fired++; });
+    });
+
+    wheel.Tick(5);
+    TS_ASSERT_EQUALS(fired, 2);
+  }
+};
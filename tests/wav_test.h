@@ -0,0 +1,86 @@
+#include <cxxtest/TestSuite.h>
+#include <wav.hpp>
+#include <alaw.hpp>
+#include <vector>
+
+class WavTest : public CxxTest::TestSuite {
+ public:
+  // Reference implementation of the A-law decoder
+  int16_t DecodeReference(int8_t number) {
+    uint8_t sign = 0x00;
+    uint8_t position = 0;
+    int16_t decoded = 0;
+    number^=0x55;
+
+    if (number & 0x80) {
+      number&=~(1<<7);
+      sign = -1;
+    }
+
+    position = ((number & 0xF0) >> 4) + 4;
+
+    if (position != 4) {
+      decoded = ((1 << position) | ((number & 0x0F) << (position - 4))
+        | (1 << (position - 5)));
+    } else {
+      decoded = (number << 1) | 1;
+    }
+
+    return (sign == 0) ? (decoded) : (-decoded);
+  }
+
+  // All 256 values in a buffer whose length is not a multiple of the vector size
+  std::vector<int8_t> AllAlawValues() {
+    std::vector<int8_t> alaw_samples;
+    for (int i = 0; i < 1000; i++) {
+      alaw_samples.push_back(static_cast<int8_t>((i * 37) % 256));
+    }
+    return alaw_samples;
+  }
+
+  void test_alaw_table () {
+    for (int i = 0; i < 256; i++) {
+      TS_ASSERT_EQUALS(alaw_table.values[i], DecodeReference(static_cast<int8_t>(i)));
+    }
+  }
+
+  void test_alaw_decode () {
+    std::vector<int8_t> alaw_samples = AllAlawValues();
+    std::vector<int16_t> samples(alaw_samples.size());
+    DecodeAlaw(alaw_samples.data(), alaw_samples.size(), samples.data());
+
+    for (size_t i = 0; i < alaw_samples.size(); i++) {
+      TS_ASSERT_EQUALS(samples[i], DecodeReference(alaw_samples[i]));
+    }
+  }
+
+  void test_alaw_kernels () {
+#if defined(__x86_64__) || defined(__i386__)
+    std::vector<int8_t> alaw_samples = AllAlawValues();
+    std::vector<int16_t> expected(alaw_samples.size());
+    std::vector<int16_t> samples(alaw_samples.size());
+    DecodeAlawScalar(alaw_samples.data(), alaw_samples.size(), expected.data());
+
+    if (__builtin_cpu_supports("ssse3")) {
+      DecodeAlawSSSE3(alaw_samples.data(), alaw_samples.size(), samples.data());
+      TS_ASSERT(samples == expected);
+    }
+    if (__builtin_cpu_supports("avx2")) {
+      DecodeAlawAVX2(alaw_samples.data(), alaw_samples.size(), samples.data());
+      TS_ASSERT(samples == expected);
+    }
+#endif
+  }
+
+  void test_read_alaw () {
+    std::vector<int8_t> alaw_samples = AllAlawValues();
+    Wav wav;
+    TS_ASSERT(wav.Read(alaw_samples));
+
+    SampleView samples = wav.GetSamples();
+    TS_ASSERT_EQUALS(samples.size(), alaw_samples.size());
+    for (size_t i = 0; i < samples.size(); i++) {
+      TS_ASSERT_EQUALS(samples[i], DecodeReference(alaw_samples[i]));
+    }
+  }
+};